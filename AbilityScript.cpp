@@ -0,0 +1,643 @@
+#include "AbilityScript.h"
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include "MemoryUsage.h"
+#include "character.h"
+
+namespace {
+
+enum class Op : std::int32_t {
+    Push,           // value
+    LoadStat,       // side, stat index
+    LoadHealth,     // side
+    LoadMaxHealth,  // side
+    LoadLevel,      // side
+    HasEffect,      // side, effect index
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Negate,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Equal,
+    NotEqual,
+    JumpIfFalse,  // target pc
+    Jump,         // target pc
+    Damage,       // side
+    Heal,         // side
+    ApplyStatus,  // side, effect index
+    SetStat,      // side, stat index
+    Fail,
+    End
+};
+
+const char* OP_NAMES[] = {"push",   "load_stat", "load_health", "load_max_health",
+                          "load_level", "has_effect", "add", "sub", "mul", "div",
+                          "neg", "lt", "le", "gt", "ge", "eq", "ne", "jump_if_false",
+                          "jump", "damage", "heal", "apply_status", "set_stat", "fail",
+                          "end"};
+
+int operandCount(Op op) {
+    switch (op) {
+        case Op::LoadStat:
+        case Op::HasEffect:
+        case Op::ApplyStatus:
+        case Op::SetStat:
+            return 2;
+        case Op::Push:
+        case Op::LoadHealth:
+        case Op::LoadMaxHealth:
+        case Op::LoadLevel:
+        case Op::JumpIfFalse:
+        case Op::Jump:
+        case Op::Damage:
+        case Op::Heal:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+const std::int32_t CASTER = 0;
+const std::int32_t TARGET = 1;
+
+// keeps intermediate results in int range so the int64 stack never overflows
+std::int64_t clampInt(std::int64_t value) {
+    return std::max<std::int64_t>(std::numeric_limits<int>::min(),
+                                  std::min<std::int64_t>(std::numeric_limits<int>::max(), value));
+}
+
+struct Token {
+    enum Kind { Number, Word, Quoted, Symbol, EndOfLine } kind{EndOfLine};
+    std::string text{};
+    std::int64_t value{};
+};
+
+std::vector<Token> tokenize(const std::string& line, int lineNumber) {
+    std::vector<Token> tokens;
+    size_t i = 0;
+
+    auto fail = [&](const std::string& message) {
+        throw std::domain_error("line " + std::to_string(lineNumber) + ": " + message);
+    };
+
+    while (i < line.size()) {
+        char c = line[i];
+
+        if (c == '#') {
+            break;
+        }
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            i++;
+            continue;
+        }
+
+        Token token;
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            size_t start = i;
+            while (i < line.size() && std::isdigit(static_cast<unsigned char>(line[i]))) {
+                i++;
+            }
+            token.kind = Token::Number;
+            token.text = line.substr(start, i - start);
+            if (token.text.size() > 9) {
+                fail("number too large: " + token.text);
+            }
+            token.value = std::stoll(token.text);
+        } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            size_t start = i;
+            while (i < line.size() && (std::isalnum(static_cast<unsigned char>(line[i])) ||
+                                       line[i] == '_')) {
+                i++;
+            }
+            token.kind = Token::Word;
+            token.text = line.substr(start, i - start);
+        } else if (c == '"') {
+            size_t end = line.find('"', i + 1);
+            if (end == std::string::npos) {
+                fail("unterminated quoted name");
+            }
+            token.kind = Token::Quoted;
+            token.text = line.substr(i + 1, end - i - 1);
+            i = end + 1;
+        } else {
+            std::string two = line.substr(i, 2);
+            token.kind = Token::Symbol;
+            if (two == "<=" || two == ">=" || two == "==" || two == "!=") {
+                token.text = two;
+                i += 2;
+            } else if (std::string("+-*/().<>").find(c) != std::string::npos) {
+                token.text = std::string(1, c);
+                i++;
+            } else {
+                fail(std::string("unexpected character '") + c + "'");
+            }
+        }
+
+        tokens.push_back(token);
+    }
+
+    tokens.push_back(Token{});
+    return tokens;
+}
+
+}  // namespace
+
+// single-pass compiler: each line is tokenized and emitted directly, with
+// forward jumps patched when their else/end is reached
+class AbilityCompiler {
+private:
+    struct Block {
+        size_t pendingJump{};  // operand slot to patch at else/end
+        bool sawElse{};
+    };
+
+    AbilityProgram& program;
+    std::map<std::string, std::int32_t> statIndex{};
+    std::map<std::string, std::int32_t> effectIndex{};
+    std::vector<Block> blocks{};
+
+    std::vector<Token> tokens{};
+    size_t pos{};
+    int lineNumber{};
+    int depth{};
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw std::domain_error("line " + std::to_string(lineNumber) + ": " + message);
+    }
+
+    const Token& peek() const { return tokens[pos]; }
+    Token next() { return tokens[pos++]; }
+
+    bool acceptSymbol(const std::string& symbol) {
+        if (peek().kind == Token::Symbol && peek().text == symbol) {
+            pos++;
+            return true;
+        }
+        return false;
+    }
+
+    void expectSymbol(const std::string& symbol) {
+        if (!acceptSymbol(symbol)) {
+            fail("expected '" + symbol + "'");
+        }
+    }
+
+    void expectEnd() {
+        if (peek().kind != Token::EndOfLine) {
+            fail("unexpected '" + peek().text + "'");
+        }
+    }
+
+    std::string name() {
+        Token token = next();
+        if (token.kind != Token::Word && token.kind != Token::Quoted) {
+            fail("expected a name");
+        }
+        return token.text;
+    }
+
+    std::int32_t side() {
+        Token token = next();
+        if (token.kind == Token::Word && token.text == "caster") {
+            return CASTER;
+        }
+        if (token.kind == Token::Word && token.text == "target") {
+            return TARGET;
+        }
+        fail("expected caster or target");
+    }
+
+    std::int32_t stat(const std::string& stat) {
+        auto it = statIndex.find(stat);
+        if (it != statIndex.end()) {
+            return it->second;
+        }
+
+        std::int32_t index = static_cast<std::int32_t>(program.statNames.size());
+        program.statNames.push_back(stat);
+        program.statIds.push_back(StatRegistry::global().idFor(stat));
+        statIndex[stat] = index;
+        return index;
+    }
+
+    std::int32_t effect(const std::string& effect) {
+        auto it = effectIndex.find(effect);
+        if (it != effectIndex.end()) {
+            return it->second;
+        }
+
+        std::int32_t index = static_cast<std::int32_t>(program.effectNames.size());
+        program.effectNames.push_back(effect);
+        program.effectIds.push_back(StatusEffectManager::global().idFor(effect));
+        effectIndex[effect] = index;
+        return index;
+    }
+
+    // stack effect: +pushed -popped
+    void emit(Op op, int stackEffect) {
+        program.code.push_back(static_cast<std::int32_t>(op));
+        depth += stackEffect;
+        if (depth > AbilityProgram::MAX_STACK) {
+            fail("expression too deeply nested");
+        }
+    }
+
+    void operand(std::int32_t value) { program.code.push_back(value); }
+
+    size_t here() const { return program.code.size(); }
+
+    void factor() {
+        if (acceptSymbol("(")) {
+            expression();
+            expectSymbol(")");
+            return;
+        }
+        if (acceptSymbol("-")) {
+            factor();
+            emit(Op::Negate, 0);
+            return;
+        }
+        if (peek().kind == Token::Number) {
+            emit(Op::Push, 1);
+            operand(static_cast<std::int32_t>(next().value));
+            return;
+        }
+
+        std::int32_t who = side();
+        expectSymbol(".");
+        bool quoted = peek().kind == Token::Quoted;
+        std::string field = name();
+
+        if (!quoted && field == "health") {
+            emit(Op::LoadHealth, 1);
+            operand(who);
+        } else if (!quoted && field == "maxHealth") {
+            emit(Op::LoadMaxHealth, 1);
+            operand(who);
+        } else if (!quoted && field == "level") {
+            emit(Op::LoadLevel, 1);
+            operand(who);
+        } else {
+            emit(Op::LoadStat, 1);
+            operand(who);
+            operand(stat(field));
+        }
+    }
+
+    void term() {
+        factor();
+        while (true) {
+            if (acceptSymbol("*")) {
+                factor();
+                emit(Op::Multiply, -1);
+            } else if (acceptSymbol("/")) {
+                factor();
+                emit(Op::Divide, -1);
+            } else {
+                return;
+            }
+        }
+    }
+
+    void expression() {
+        term();
+        while (true) {
+            if (acceptSymbol("+")) {
+                term();
+                emit(Op::Add, -1);
+            } else if (acceptSymbol("-")) {
+                term();
+                emit(Op::Subtract, -1);
+            } else {
+                return;
+            }
+        }
+    }
+
+    void condition() {
+        // <who> has <effect>
+        if (peek().kind == Token::Word && tokens[pos + 1].kind == Token::Word &&
+            tokens[pos + 1].text == "has") {
+            std::int32_t who = side();
+            pos++;
+            emit(Op::HasEffect, 1);
+            operand(who);
+            operand(effect(name()));
+            return;
+        }
+
+        expression();
+
+        static const std::map<std::string, Op> comparisons = {
+            {"<", Op::Less},         {"<=", Op::LessEqual}, {">", Op::Greater},
+            {">=", Op::GreaterEqual}, {"==", Op::Equal},     {"!=", Op::NotEqual}};
+
+        Token token = next();
+        auto it = comparisons.find(token.text);
+        if (token.kind != Token::Symbol || it == comparisons.end()) {
+            fail("expected a comparison");
+        }
+
+        expression();
+        emit(it->second, -1);
+    }
+
+    void statement() {
+        Token keyword = next();
+        if (keyword.kind == Token::EndOfLine) {
+            return;
+        }
+        if (keyword.kind != Token::Word) {
+            fail("expected a statement");
+        }
+
+        const std::string& word = keyword.text;
+        if (word == "damage" || word == "heal") {
+            std::int32_t who = side();
+            expression();
+            emit(word == "damage" ? Op::Damage : Op::Heal, -1);
+            operand(who);
+        } else if (word == "status") {
+            std::int32_t who = side();
+            std::int32_t index = effect(name());
+            expression();
+            emit(Op::ApplyStatus, -1);
+            operand(who);
+            operand(index);
+        } else if (word == "set") {
+            std::int32_t who = side();
+            std::int32_t index = stat(name());
+            expression();
+            emit(Op::SetStat, -1);
+            operand(who);
+            operand(index);
+        } else if (word == "if") {
+            condition();
+            emit(Op::JumpIfFalse, -1);
+            blocks.push_back({here(), false});
+            operand(0);
+        } else if (word == "else") {
+            if (blocks.empty() || blocks.back().sawElse) {
+                fail("else without if");
+            }
+            emit(Op::Jump, 0);
+            size_t jump = here();
+            operand(0);
+            program.code[blocks.back().pendingJump] = static_cast<std::int32_t>(here());
+            blocks.back() = {jump, true};
+        } else if (word == "end") {
+            if (blocks.empty()) {
+                fail("end without if");
+            }
+            program.code[blocks.back().pendingJump] = static_cast<std::int32_t>(here());
+            blocks.pop_back();
+        } else if (word == "fail") {
+            emit(Op::Fail, 0);
+        } else {
+            fail("unknown statement '" + word + "'");
+        }
+
+        expectEnd();
+    }
+
+public:
+    explicit AbilityCompiler(AbilityProgram& program) : program{program} {}
+
+    void compile(const std::string& source) {
+        std::stringstream ss(source);
+        std::string line;
+
+        while (std::getline(ss, line)) {
+            lineNumber++;
+            tokens = tokenize(line, lineNumber);
+            pos = 0;
+            statement();
+        }
+
+        if (!blocks.empty()) {
+            fail("missing end");
+        }
+        emit(Op::End, 0);
+    }
+};
+
+std::shared_ptr<const AbilityProgram> AbilityProgram::compile(const std::string& source) {
+    auto program = std::make_shared<AbilityProgram>();
+    program->source = source;
+
+    AbilityCompiler compiler(*program);
+    compiler.compile(source);
+
+    program->code.shrink_to_fit();
+    return program;
+}
+
+bool AbilityProgram::execute(Character& caster, Character& target,
+                             std::uint64_t& executed) const {
+    Character* sides[2] = {&caster, &target};
+    std::int64_t stack[MAX_STACK];
+    int top = 0;
+
+    const std::int32_t* pc = code.data();
+    const std::int32_t* start = pc;
+
+    while (true) {
+        executed++;
+
+        switch (static_cast<Op>(*pc++)) {
+            case Op::Push:
+                stack[top++] = *pc++;
+                break;
+            case Op::LoadStat: {
+                Character* who = sides[pc[0]];
+                stack[top++] = who->getStat(statIds[pc[1]]);
+                pc += 2;
+                break;
+            }
+            case Op::LoadHealth:
+                stack[top++] = sides[*pc++]->getHealth();
+                break;
+            case Op::LoadMaxHealth:
+                stack[top++] = sides[*pc++]->getMaxHealth();
+                break;
+            case Op::LoadLevel:
+                stack[top++] = sides[*pc++]->getLevel();
+                break;
+            case Op::HasEffect:
+                stack[top++] = sides[pc[0]]->hasStatusEffect(effectIds[pc[1]]) ? 1 : 0;
+                pc += 2;
+                break;
+            case Op::Add:
+                top--;
+                stack[top - 1] = clampInt(stack[top - 1] + stack[top]);
+                break;
+            case Op::Subtract:
+                top--;
+                stack[top - 1] = clampInt(stack[top - 1] - stack[top]);
+                break;
+            case Op::Multiply:
+                top--;
+                stack[top - 1] = clampInt(stack[top - 1] * stack[top]);
+                break;
+            case Op::Divide:
+                top--;
+                stack[top - 1] = stack[top] == 0 ? 0 : clampInt(stack[top - 1] / stack[top]);
+                break;
+            case Op::Negate:
+                stack[top - 1] = clampInt(-stack[top - 1]);
+                break;
+            case Op::Less:
+                top--;
+                stack[top - 1] = stack[top - 1] < stack[top];
+                break;
+            case Op::LessEqual:
+                top--;
+                stack[top - 1] = stack[top - 1] <= stack[top];
+                break;
+            case Op::Greater:
+                top--;
+                stack[top - 1] = stack[top - 1] > stack[top];
+                break;
+            case Op::GreaterEqual:
+                top--;
+                stack[top - 1] = stack[top - 1] >= stack[top];
+                break;
+            case Op::Equal:
+                top--;
+                stack[top - 1] = stack[top - 1] == stack[top];
+                break;
+            case Op::NotEqual:
+                top--;
+                stack[top - 1] = stack[top - 1] != stack[top];
+                break;
+            case Op::JumpIfFalse:
+                if (stack[--top] == 0) {
+                    pc = start + *pc;
+                } else {
+                    pc++;
+                }
+                break;
+            case Op::Jump:
+                pc = start + *pc;
+                break;
+            case Op::Damage:
+                // negative amounts never heal
+                sides[*pc++]->takeDamage(static_cast<int>(std::max<std::int64_t>(0, stack[--top])));
+                break;
+            case Op::Heal:
+                sides[*pc++]->heal(static_cast<int>(std::max<std::int64_t>(0, stack[--top])));
+                break;
+            case Op::ApplyStatus:
+                sides[pc[0]]->applyStatusEffect(effectIds[pc[1]],
+                                                static_cast<int>(stack[--top]));
+                pc += 2;
+                break;
+            case Op::SetStat:
+                sides[pc[0]]->setStat(statIds[pc[1]], static_cast<int>(stack[--top]));
+                pc += 2;
+                break;
+            case Op::Fail:
+                return false;
+            case Op::End:
+                return true;
+        }
+    }
+}
+
+bool AbilityProgram::run(Character& caster, Character& target) const {
+    std::uint64_t executed = 0;
+    bool used = execute(caster, target, executed);
+
+    runs.fetch_add(1, std::memory_order_relaxed);
+    instructions.fetch_add(executed, std::memory_order_relaxed);
+    return used;
+}
+
+int AbilityProgram::runBatch(Character& caster, const std::vector<Character*>& targets) const {
+    std::uint64_t executed = 0;
+    int used = 0;
+
+    for (Character* target : targets) {
+        if (execute(caster, *target, executed)) {
+            used++;
+        }
+    }
+
+    runs.fetch_add(targets.size(), std::memory_order_relaxed);
+    instructions.fetch_add(executed, std::memory_order_relaxed);
+    return used;
+}
+
+const std::string& AbilityProgram::getSource() const { return source; }
+
+std::string AbilityProgram::disassemble() const {
+    std::stringstream ss;
+
+    size_t pc = 0;
+    while (pc < code.size()) {
+        Op op = static_cast<Op>(code[pc]);
+        ss << pc << ": " << OP_NAMES[static_cast<int>(op)];
+
+        const std::int32_t* operands = &code[pc + 1];
+        switch (op) {
+            case Op::LoadStat:
+            case Op::SetStat:
+                ss << ' ' << (operands[0] == CASTER ? "caster" : "target") << " \""
+                   << statNames[operands[1]] << '"';
+                break;
+            case Op::HasEffect:
+            case Op::ApplyStatus:
+                ss << ' ' << (operands[0] == CASTER ? "caster" : "target") << " \""
+                   << effectNames[operands[1]] << '"';
+                break;
+            case Op::LoadHealth:
+            case Op::LoadMaxHealth:
+            case Op::LoadLevel:
+            case Op::Damage:
+            case Op::Heal:
+                ss << ' ' << (operands[0] == CASTER ? "caster" : "target");
+                break;
+            case Op::Push:
+            case Op::JumpIfFalse:
+            case Op::Jump:
+                ss << ' ' << operands[0];
+                break;
+            default:
+                break;
+        }
+
+        ss << '\n';
+        pc += 1 + operandCount(op);
+    }
+
+    return ss.str();
+}
+
+size_t AbilityProgram::getCodeSize() const { return code.size(); }
+
+size_t AbilityProgram::getHeapBytes() const {
+    size_t bytes = memory::stringHeap(source) + memory::vectorHeap(code) +
+                   memory::vectorHeap(statNames) + memory::vectorHeap(statIds) +
+                   memory::vectorHeap(effectNames) +
+                   memory::vectorHeap(effectIds);
+    for (const auto& stat : statNames) {
+        bytes += memory::stringHeap(stat);
+    }
+    for (const auto& effect : effectNames) {
+        bytes += memory::stringHeap(effect);
+    }
+    return bytes;
+}
+
+std::uint64_t AbilityProgram::getRunCount() const { return runs; }
+
+std::uint64_t AbilityProgram::getInstructionCount() const { return instructions; }
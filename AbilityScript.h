@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "StatRegistry.h"
+#include "StatusEffect.h"
+
+class Character;
+
+// an ability written in a small script language and compiled to bytecode.
+// one statement per line, '#' starts a comment:
+//   damage <who> <expr>
+//   heal <who> <expr>
+//   status <who> <effect> <turns expr>
+//   set <who> <stat> <expr>
+//   if <expr> <op> <expr>       op is one of < <= > >= == !=
+//   if <who> has <effect>
+//   else
+//   end
+//   fail                        stop and report the ability as not used
+// <who> is caster or target. expressions combine integers, + - * / and
+// parentheses, <who>.<stat>, and the built-ins <who>.health, <who>.maxHealth
+// and <who>.level. names with spaces are written in double quotes, e.g.
+// caster."Spell Power". division truncates and dividing by zero gives 0.
+//
+// stat names and effects are resolved once at compile time to StatIds and
+// StatusEffectIds, so a run never parses or allocates and reading a stat is a
+// vector index. writing one still goes through the character's name map. programs are immutable after compile
+// and safe to share and run from several threads at once.
+class AbilityProgram {
+public:
+    static constexpr int MAX_STACK = 32;
+
+private:
+    std::string source{};
+    std::vector<std::int32_t> code{};
+    std::vector<std::string> statNames{};
+    std::vector<StatId> statIds{};
+    std::vector<std::string> effectNames{};
+    std::vector<StatusEffectId> effectIds{};
+
+    mutable std::atomic<std::uint64_t> runs{0};
+    mutable std::atomic<std::uint64_t> instructions{0};
+
+    bool execute(Character& caster, Character& target, std::uint64_t& executed) const;
+
+    friend class AbilityCompiler;
+
+public:
+    // throws std::domain_error naming the offending line
+    static std::shared_ptr<const AbilityProgram> compile(const std::string& source);
+
+    bool run(Character& caster, Character& target) const;
+    // runs the ability against every target in order; returns how many runs
+    // reported success
+    int runBatch(Character& caster, const std::vector<Character*>& targets) const;
+
+    const std::string& getSource() const;
+    // one instruction per line, for inspecting what a script compiled to
+    std::string disassemble() const;
+    size_t getCodeSize() const;
+    size_t getHeapBytes() const;
+
+    // profiling counters, accumulated over every run of this program
+    std::uint64_t getRunCount() const;
+    std::uint64_t getInstructionCount() const;
+};
+
+// compiled programs keyed by the string table index of their source, so a
+// party load compiles each distinct script once
+using AbilityProgramCache = std::map<std::uint64_t, std::shared_ptr<const AbilityProgram>>;
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+// little-endian helpers shared by the binary save formats. readers advance pos
+// and throw std::domain_error when the data ends early.
+namespace binary {
+
+inline void putU32(std::string& out, std::uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+}
+
+inline void putU64(std::string& out, std::uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        out.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+}
+
+inline void putString(std::string& out, const std::string& value) {
+    putU32(out, static_cast<std::uint32_t>(value.size()));
+    out += value;
+}
+
+// LEB128 varint; small values take one byte
+inline void putVarUint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+// zigzag-encoded so small negative values stay short too
+inline void putVarInt(std::string& out, std::int64_t value) {
+    putVarUint(out, (static_cast<std::uint64_t>(value) << 1) ^
+                        static_cast<std::uint64_t>(value >> 63));
+}
+
+inline void requireBytes(const std::string& data, size_t pos, size_t count) {
+    if (pos > data.size() || count > data.size() - pos) {
+        throw std::domain_error("truncated binary data");
+    }
+}
+
+inline std::uint32_t getU32(const std::string& data, size_t& pos) {
+    requireBytes(data, pos, 4);
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value |= static_cast<std::uint32_t>(static_cast<unsigned char>(data[pos++]))
+                 << (i * 8);
+    }
+    return value;
+}
+
+inline std::uint64_t getU64(const std::string& data, size_t& pos) {
+    requireBytes(data, pos, 8);
+    std::uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[pos++]))
+                 << (i * 8);
+    }
+    return value;
+}
+
+inline std::string getString(const std::string& data, size_t& pos) {
+    std::uint32_t length = getU32(data, pos);
+    requireBytes(data, pos, length);
+    std::string value = data.substr(pos, length);
+    pos += length;
+    return value;
+}
+
+inline std::uint64_t getVarUint(const std::string& data, size_t& pos) {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        requireBytes(data, pos, 1);
+        std::uint64_t byte = static_cast<unsigned char>(data[pos++]);
+        value |= (byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw std::domain_error("malformed varint");
+}
+
+inline std::int64_t getVarInt(const std::string& data, size_t& pos) {
+    std::uint64_t value = getVarUint(data, pos);
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+// 32-bit FNV-1a, used to detect torn or corrupted records
+inline std::uint32_t checksum(const char* data, size_t size) {
+    std::uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+}  // namespace binary
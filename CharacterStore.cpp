@@ -0,0 +1,553 @@
+#include "CharacterStore.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "BinaryCodec.h"
+
+namespace {
+using namespace binary;
+
+const char* LOG_FILE = "characters.wal";
+const char* SNAPSHOT_FILE = "characters.snapshot";
+
+const std::uint8_t RECORD_UPDATE = 0;
+const std::uint8_t RECORD_ERASE = 1;
+
+std::runtime_error systemError(const std::string& what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+void writeAll(int fd, const std::string& data, const std::string& path) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t written = ::write(fd, data.data() + offset, data.size() - offset);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0) {
+            throw systemError("write " + path);
+        }
+        offset += static_cast<size_t>(written);
+    }
+}
+
+void syncFile(int fd, const std::string& path) {
+    if (::fdatasync(fd) < 0) {
+        throw systemError("fsync " + path);
+    }
+}
+
+std::string readFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return "";
+        }
+        throw systemError("open " + path);
+    }
+
+    std::string data;
+    char buffer[65536];
+    while (true) {
+        ssize_t received = ::read(fd, buffer, sizeof(buffer));
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received < 0) {
+            ::close(fd);
+            throw systemError("read " + path);
+        }
+        if (received == 0) {
+            break;
+        }
+        data.append(buffer, static_cast<size_t>(received));
+    }
+
+    ::close(fd);
+    return data;
+}
+
+// wraps a record payload as length + checksum + payload
+std::string frameRecord(const std::string& payload) {
+    std::string frame;
+    putU32(frame, static_cast<std::uint32_t>(payload.size()));
+    putU32(frame, checksum(payload.data(), payload.size()));
+    frame += payload;
+    return frame;
+}
+
+// calls apply(payload) for each intact record and returns the offset just
+// past the last one
+template <typename Apply>
+size_t readRecords(const std::string& data, Apply apply) {
+    size_t pos = 0;
+    while (data.size() - pos >= 8) {
+        size_t start = pos;
+        std::uint32_t length = getU32(data, pos);
+        std::uint32_t expected = getU32(data, pos);
+
+        if (length > data.size() - pos ||
+            checksum(data.data() + pos, length) != expected) {
+            return start;
+        }
+
+        apply(data.substr(pos, length));
+        pos += length;
+    }
+    return pos;
+}
+
+std::string encodeUpdate(const std::string& name,
+                         const std::map<std::string, std::string>& changed,
+                         const std::vector<std::string>& removed) {
+    std::string payload;
+    payload.push_back(static_cast<char>(RECORD_UPDATE));
+    putString(payload, name);
+
+    putU32(payload, static_cast<std::uint32_t>(changed.size()));
+    for (const auto& pair : changed) {
+        putString(payload, pair.first);
+        putString(payload, pair.second);
+    }
+
+    putU32(payload, static_cast<std::uint32_t>(removed.size()));
+    for (const auto& field : removed) {
+        putString(payload, field);
+    }
+
+    return payload;
+}
+
+// flattens Character::serialize output into field -> value
+std::map<std::string, std::string> flatten(const std::string& data, std::string& name) {
+    std::map<std::string, std::string> fields;
+    std::stringstream ss(data);
+
+    std::getline(ss, name);
+    std::getline(ss, fields["level"]);
+    std::getline(ss, fields["experience"]);
+
+    const char* prefixes[] = {"stat:", "item:", "gear:"};
+    for (const char* prefix : prefixes) {
+        std::string line;
+        std::getline(ss, line);
+        size_t count = std::stoul(line);
+
+        for (size_t i = 0; i < count; i++) {
+            std::string key;
+            std::string value;
+            std::getline(ss, key);
+            std::getline(ss, value);
+            fields[prefix + key] = value;
+        }
+    }
+
+    return fields;
+}
+
+// rebuilds Character::serialize output from flattened fields
+std::string unflatten(const std::string& name,
+                      const std::map<std::string, std::string>& fields) {
+    std::stringstream ss;
+    ss << name << '\n';
+    ss << fields.at("level") << '\n';
+    ss << fields.at("experience") << '\n';
+
+    const std::string prefixes[] = {"stat:", "item:", "gear:"};
+    for (const auto& prefix : prefixes) {
+        std::vector<std::pair<std::string, std::string>> section;
+        for (auto it = fields.lower_bound(prefix);
+             it != fields.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            section.push_back({it->first.substr(prefix.size()), it->second});
+        }
+
+        ss << section.size() << '\n';
+        for (const auto& pair : section) {
+            ss << pair.first << '\n';
+            ss << pair.second << '\n';
+        }
+    }
+
+    return ss.str();
+}
+}  // namespace
+
+CharacterStore::CharacterStore(const std::string& directory) : directory{directory}, writeLog{writeAll} {
+    std::filesystem::create_directories(directory);
+    recover();
+
+    logFd = ::open(logPath().c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (logFd < 0) {
+        throw systemError("open " + logPath());
+    }
+}
+
+CharacterStore::~CharacterStore() {
+    if (logFd >= 0) {
+        ::close(logFd);
+    }
+}
+
+std::string CharacterStore::logPath() const { return directory + "/" + LOG_FILE; }
+
+std::string CharacterStore::snapshotPath() const {
+    return directory + "/" + SNAPSHOT_FILE;
+}
+
+void CharacterStore::recover() {
+    std::string snapshot = readFile(snapshotPath());
+    readRecords(snapshot, [this](const std::string& payload) { applyRecord(payload); });
+
+    std::string log = readFile(logPath());
+    size_t intact =
+        readRecords(log, [this](const std::string& payload) { applyRecord(payload); });
+
+    // drop a torn tail so new records are not appended after garbage
+    if (intact < log.size()) {
+        if (::truncate(logPath().c_str(), static_cast<off_t>(intact)) < 0) {
+            throw systemError("truncate " + logPath());
+        }
+    }
+    logBytes = intact;
+}
+
+void CharacterStore::applyRecord(const std::string& payload) {
+    size_t pos = 0;
+    requireBytes(payload, pos, 1);
+    std::uint8_t type = static_cast<std::uint8_t>(payload[pos++]);
+    std::string name = getString(payload, pos);
+
+    if (type == RECORD_ERASE) {
+        states.erase(name);
+        return;
+    }
+
+    Fields& fields = states[name];
+
+    std::uint32_t changedCount = getU32(payload, pos);
+    for (std::uint32_t i = 0; i < changedCount; i++) {
+        std::string field = getString(payload, pos);
+        fields[field] = getString(payload, pos);
+    }
+
+    std::uint32_t removedCount = getU32(payload, pos);
+    for (std::uint32_t i = 0; i < removedCount; i++) {
+        fields.erase(getString(payload, pos));
+    }
+}
+
+const CharacterStore::Fields* CharacterStore::latestFields(const std::string& name) const {
+    for (const Batch* batch : {open.get(), writing.get()}) {
+        if (batch != nullptr) {
+            auto it = batch->changes.find(name);
+            if (it != batch->changes.end()) {
+                return it->second ? &*it->second : nullptr;
+            }
+        }
+    }
+
+    auto it = states.find(name);
+    return it != states.end() ? &it->second : nullptr;
+}
+
+void CharacterStore::save(const Character& character) {
+    std::string name;
+    Fields fields = flatten(character.serialize(), name);
+
+    // serialize leaves these out
+    fields["health"] = std::to_string(character.getHealth());
+    fields["maxHealth"] = std::to_string(character.getMaxHealth());
+    for (const auto& effect : character.getStatusEffects()) {
+        fields["effect:" + effect.first] = std::to_string(effect.second);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // only fields that differ from the last logged state are logged
+    static const Fields none;
+    const Fields* latest = latestFields(name);
+    const Fields& current = latest != nullptr ? *latest : none;
+    Fields changed;
+    std::vector<std::string> removed;
+
+    for (const auto& pair : fields) {
+        auto it = current.find(pair.first);
+        if (it == current.end() || it->second != pair.second) {
+            changed.insert(pair);
+        }
+    }
+    for (const auto& pair : current) {
+        if (fields.count(pair.first) == 0) {
+            removed.push_back(pair.first);
+        }
+    }
+
+    if (changed.empty() && removed.empty()) {
+        // nothing new, but an earlier save of this state may still be in flight
+        for (const auto& batch : {open, writing}) {
+            if (batch != nullptr && batch->changes.count(name) != 0) {
+                waitDurable(batch, lock);
+                return;
+            }
+        }
+        return;
+    }
+
+    append(name, encodeUpdate(name, changed, removed), std::move(fields), lock);
+}
+
+void CharacterStore::erase(const std::string& name) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    if (latestFields(name) == nullptr) {
+        return;
+    }
+
+    std::string payload;
+    payload.push_back(static_cast<char>(RECORD_ERASE));
+    putString(payload, name);
+    append(name, payload, std::nullopt, lock);
+}
+
+void CharacterStore::append(const std::string& name, const std::string& payload,
+                            std::optional<Fields> fields, std::unique_lock<std::mutex>& lock) {
+    std::shared_ptr<Batch> batch = open;
+    batch->records += frameRecord(payload);
+    batch->changes[name] = std::move(fields);
+    waitDurable(batch, lock);
+}
+
+void CharacterStore::waitDurable(std::shared_ptr<Batch> batch,
+                                 std::unique_lock<std::mutex>& lock) {
+    while (!batch->done) {
+        if (flushing) {
+            committed.wait(lock);
+            continue;
+        }
+
+        // this thread leads the group commit: everything in the open batch is
+        // written and synced together. the caller's batch is the open one,
+        // since any batch being written is finished before flushing clears.
+        flushing = true;
+        try {
+            flushLocked(lock);
+            if (compactionThreshold != 0 && logBytes >= compactionThreshold) {
+                compactLocked(lock);
+            }
+        } catch (...) {
+            flushing = false;
+            committed.notify_all();
+            // a failed compaction leaves the log intact, so a batch that was
+            // already synced is still durable; the next leader compacts again
+            if (!batch->done) {
+                throw;
+            }
+            break;
+        }
+
+        flushing = false;
+        committed.notify_all();
+    }
+
+    if (!batch->error.empty()) {
+        throw std::runtime_error(batch->error);
+    }
+}
+
+void CharacterStore::flushLocked(std::unique_lock<std::mutex>& lock) {
+    // caller holds the flushing role
+    writing = open;
+    open = std::make_shared<Batch>();
+
+    if (writing->records.empty()) {
+        writing->done = true;
+        writing = nullptr;
+        return;
+    }
+    if (!logDamage.empty()) {
+        failLocked(logDamage);
+        return;
+    }
+
+    std::string error;
+    lock.unlock();
+    try {
+        writeLog(logFd, writing->records, logPath());
+        syncFile(logFd, logPath());
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+    lock.lock();
+
+    if (!error.empty()) {
+        failLocked(error);
+        return;
+    }
+
+    syncCount++;
+    logBytes += writing->records.size();
+    for (auto& change : writing->changes) {
+        if (change.second) {
+            states[change.first] = std::move(*change.second);
+        } else {
+            states.erase(change.first);
+        }
+    }
+    writing->changes.clear();
+    writing->done = true;
+    writing = nullptr;
+}
+
+void CharacterStore::failLocked(const std::string& error) {
+    // cut off whatever part of the batch reached the file so the next batch
+    // does not land after a torn record, which recovery would stop at
+    if (logDamage.empty() && ::ftruncate(logFd, static_cast<off_t>(logBytes)) < 0) {
+        logDamage = "log unusable after a failed write: " + error;
+    }
+
+    writing->done = true;
+    writing->error = error;
+    writing = nullptr;
+
+    // records queued behind the failed ones were diffed against them
+    open->done = true;
+    open->error = "an earlier record failed: " + error;
+    open = std::make_shared<Batch>();
+}
+
+void CharacterStore::compactLocked(std::unique_lock<std::mutex>& lock) {
+    // caller holds the flushing role. make the open batch durable first so
+    // the snapshot covers every record appended so far
+    flushLocked(lock);
+
+    std::string snapshot;
+    for (const auto& pair : states) {
+        snapshot += frameRecord(encodeUpdate(pair.first, pair.second, {}));
+    }
+
+    lock.unlock();
+    try {
+        std::string temporary = snapshotPath() + ".tmp";
+        int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw systemError("open " + temporary);
+        }
+        try {
+            writeAll(fd, snapshot, temporary);
+            syncFile(fd, temporary);
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+
+        if (::rename(temporary.c_str(), snapshotPath().c_str()) < 0) {
+            throw systemError("rename " + temporary);
+        }
+
+        int directoryFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+        if (directoryFd >= 0) {
+            ::fsync(directoryFd);
+            ::close(directoryFd);
+        }
+
+        // the snapshot now covers every logged record
+        if (::ftruncate(logFd, 0) < 0) {
+            throw systemError("truncate " + logPath());
+        }
+        syncFile(logFd, logPath());
+    } catch (...) {
+        lock.lock();
+        throw;
+    }
+    lock.lock();
+
+    syncCount += 2;
+    compactionCount++;
+    logBytes = 0;
+}
+
+void CharacterStore::compact() {
+    std::unique_lock<std::mutex> lock(mutex);
+    committed.wait(lock, [this]() { return !flushing; });
+
+    flushing = true;
+    try {
+        compactLocked(lock);
+    } catch (...) {
+        flushing = false;
+        committed.notify_all();
+        throw;
+    }
+    flushing = false;
+    committed.notify_all();
+}
+
+void CharacterStore::setCompactionThreshold(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    compactionThreshold = bytes;
+}
+
+bool CharacterStore::has(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return states.count(name) != 0;
+}
+
+Character CharacterStore::load(const std::string& name) const {
+    Fields fields;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = states.find(name);
+        if (it == states.end()) {
+            throw std::domain_error("no saved character named " + name);
+        }
+        fields = it->second;
+    }
+
+    Character character = Character::deserialize(unflatten(name, fields));
+
+    // logs written before health was persisted leave it at zero
+    auto maxHealth = fields.find("maxHealth");
+    auto health = fields.find("health");
+    if (maxHealth != fields.end() && health != fields.end()) {
+        character.setHealth(std::stoi(maxHealth->second));
+        character.heal(std::stoi(health->second));
+    }
+
+    const std::string effectPrefix = "effect:";
+    for (auto it = fields.lower_bound(effectPrefix);
+         it != fields.end() && it->first.compare(0, effectPrefix.size(), effectPrefix) == 0;
+         ++it) {
+        character.applyStatusEffect(it->first.substr(effectPrefix.size()), std::stoi(it->second));
+    }
+
+    return character;
+}
+
+int CharacterStore::getCharacterCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<int>(states.size());
+}
+
+size_t CharacterStore::getLogSize() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return logBytes;
+}
+
+std::uint64_t CharacterStore::getSyncCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return syncCount;
+}
+
+std::uint64_t CharacterStore::getCompactionCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return compactionCount;
+}
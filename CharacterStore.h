@@ -0,0 +1,107 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "character.h"
+
+// durable character persistence. every save appends a change record holding
+// only the fields that differ from the last saved state to a write-ahead log.
+// concurrent saves are group committed: one thread writes and fsyncs the whole
+// pending batch while the others wait for it. once the log grows past the
+// compaction threshold it is folded into the snapshot file and truncated.
+// opening a store loads the snapshot and replays the log tail, dropping a torn
+// final record if the process died mid-write.
+//
+// the in-memory state only takes a record once it is durable. if a write or
+// sync fails, the log is cut back to its last durable length and every save
+// in the failed batch throws, as do saves queued behind it (their records
+// were diffed against the failed ones). a save retried after a failure logs
+// its change again. if the log cannot be cut back, every later write fails.
+//
+// the persisted state is what Character::serialize carries plus current and
+// max health and the remaining turns of each active status effect.
+class CharacterStore {
+private:
+    // flattened serialize() fields (level, experience, stat:*, item:*, gear:*)
+    // plus health, maxHealth and effect:* (remaining turns)
+    using Fields = std::map<std::string, std::string>;
+
+    // records written and synced together, and how that went
+    struct Batch {
+        std::string records{};
+        // each character's fields once the batch is durable; nullopt = erased
+        std::map<std::string, std::optional<Fields>> changes{};
+        bool done{};
+        std::string error{};
+    };
+
+    std::string directory{};
+    int logFd{-1};
+
+    mutable std::mutex mutex{};
+    std::condition_variable committed{};
+    // durable state only
+    std::map<std::string, Fields> states{};
+    // open takes new records; writing is the batch the leader has in flight
+    std::shared_ptr<Batch> open{std::make_shared<Batch>()};
+    std::shared_ptr<Batch> writing{};
+    bool flushing{};
+    std::string logDamage{};
+    size_t logBytes{};
+    size_t compactionThreshold{};
+    std::uint64_t syncCount{};
+    std::uint64_t compactionCount{};
+
+    // appends a batch to the log; only CharacterStoreTest swaps it out, to
+    // simulate failing disks
+    using LogWriter = std::function<void(int fd, const std::string& data, const std::string& path)>;
+    LogWriter writeLog{};
+    friend class CharacterStoreTest;
+
+    std::string logPath() const;
+    std::string snapshotPath() const;
+
+    void recover();
+    void applyRecord(const std::string& payload);
+    // latest fields for name including records not yet durable; nullptr if
+    // it has none
+    const Fields* latestFields(const std::string& name) const;
+    void append(const std::string& name, const std::string& payload,
+                std::optional<Fields> fields, std::unique_lock<std::mutex>& lock);
+    void waitDurable(std::shared_ptr<Batch> batch, std::unique_lock<std::mutex>& lock);
+    void flushLocked(std::unique_lock<std::mutex>& lock);
+    void failLocked(const std::string& error);
+    void compactLocked(std::unique_lock<std::mutex>& lock);
+
+public:
+    // creates the directory if needed, then recovers any existing state
+    explicit CharacterStore(const std::string& directory);
+    ~CharacterStore();
+
+    CharacterStore(const CharacterStore&) = delete;
+    CharacterStore& operator=(const CharacterStore&) = delete;
+
+    // return once the change is durable; throw if it could not be made so
+    void save(const Character& character);
+    void erase(const std::string& name);
+
+    // these see durable state only
+    bool has(const std::string& name) const;
+    Character load(const std::string& name) const;
+    int getCharacterCount() const;
+
+    // folds the log into the snapshot now
+    void compact();
+    // compact automatically once the log reaches this many bytes (0 = never)
+    void setCompactionThreshold(size_t bytes);
+
+    size_t getLogSize() const;
+    std::uint64_t getSyncCount() const;
+    std::uint64_t getCompactionCount() const;
+};
@@ -1,5 +1,20 @@
 #include "CharacterTests.h"
+#include "CharacterStore.h"
+#include "CombatPlanner.h"
 #include "Party.h"
+#include "PartySnapshot.h"
+#include "RosterSnapshot.h"
+#include "SimulationServer.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
 
 bool testCreateCharacterWithNameAndHealth() {
     Character character("Adventurer", 100);
@@ -384,10 +399,21 @@ bool testCharacterSerialization() {
     bool potionCountPreserved = ASSERT_EQ(3, loaded.getItemCount("Health Potion"));
     bool goldCountPreserved = ASSERT_EQ(150, loaded.getItemCount("Gold"));
     bool weaponPreserved = ASSERT_EQ("Longsword", loaded.getEquipped("Weapon"));
-    
+
+    // The same inventory serializes the same whatever order it was built in
+    Character forward("Packer", 50);
+    forward.addToInventory("Arrow", 5);
+    forward.addToInventory("Bow");
+    forward.addToInventory("Cloak");
+    Character backward("Packer", 50);
+    backward.addToInventory("Cloak");
+    backward.addToInventory("Bow");
+    backward.addToInventory("Arrow", 5);
+    bool canonicalOrder = ASSERT_EQ(forward.serialize(), backward.serialize());
+
     return namePreserved && levelPreserved && xpPreserved && strengthPreserved && 
            constitutionPreserved && inventoryCountPreserved && potionCountPreserved && 
-           goldCountPreserved && weaponPreserved;
+           goldCountPreserved && weaponPreserved && canonicalOrder;
 }
 
 bool testCompleteBattleScenario() {
@@ -462,3 +488,1167 @@ bool testCompleteBattleScenario() {
            round2DamageToEnemy && round2PoisonApplied && round2DamageFromPoison && 
            round2PoisonEffect && round3Healing;
 }
+
+// Test for the global item catalog backing inventories and gear
+bool testItemCatalog() {
+    ItemCatalog& catalog = ItemCatalog::global();
+    ItemId arrowId = catalog.defineItem("Catalog Test Arrow", 20);
+    catalog.defineItem("Catalog Test Axe", 1, 9);
+
+    Character character("Archer", 100);
+    character.addToInventory("Catalog Test Arrow", 15);
+    character.addToInventory("Catalog Test Arrow", 15);
+    bool stackClamped = ASSERT_EQ(20, character.getItemCount("Catalog Test Arrow"));
+
+    // Same name always maps to the same id
+    bool stableId = ASSERT_EQ(arrowId, catalog.idFor("Catalog Test Arrow"));
+
+    // Looking up missing items must not register or store anything
+    int knownItems = catalog.getItemCount();
+    bool missingIsZero = ASSERT_EQ(0, character.getItemCount("Catalog Test Missing"));
+    bool missingNotHeld = ASSERT_EQ(false, character.hasItem("Catalog Test Missing"));
+    bool catalogUnchanged = ASSERT_EQ(knownItems, catalog.getItemCount());
+    bool inventoryUnchanged = ASSERT_EQ(1, character.getInventoryCount());
+
+    // Id overloads see the same stacks as the name overloads
+    character.useItem(arrowId, 5);
+    bool idCount = ASSERT_EQ(15, character.getItemCount(arrowId));
+    bool idMatchesName = ASSERT_EQ(character.getItemCount("Catalog Test Arrow"),
+                                   character.getItemCount(arrowId));
+    character.addToInventory(arrowId, 10);
+    bool idClamped = ASSERT_EQ(20, character.getItemCount(arrowId));
+    bool idHeld = ASSERT_EQ(true, character.hasItem(arrowId));
+
+    // Weapons use the catalog's base damage unless overridden per character
+    Character target("Target", 100);
+    character.addToInventory("Catalog Test Axe");
+    character.equip("Catalog Test Axe", "Weapon");
+    character.attack(target);
+    bool baseDamage = ASSERT_EQ(91, target.getHealth());
+
+    character.setWeaponDamage("Catalog Test Axe", 4);
+    character.attack(target);
+    bool overrideDamage = ASSERT_EQ(87, target.getHealth());
+
+    // Inventories beyond the inline capacity still behave the same
+    for (int i = 0; i < 10; i++) {
+        character.addToInventory("Catalog Test Gem " + std::to_string(i), i + 1);
+    }
+    Character copy = character;
+    bool spilledCount = ASSERT_EQ(12, copy.getInventoryCount());
+    bool spilledItem = ASSERT_EQ(10, copy.getItemCount("Catalog Test Gem 9"));
+    bool equippedCopied = ASSERT_EQ("Catalog Test Axe", copy.getEquipped("Weapon"));
+
+    return stackClamped && stableId && missingIsZero && missingNotHeld &&
+           catalogUnchanged && inventoryUnchanged && idCount && idMatchesName &&
+           idClamped && idHeld && baseDamage &&
+           overrideDamage && spilledCount && spilledItem && equippedCopied;
+}
+
+// Test that the runner records timings and enforces time budgets
+bool testTestRunnerTimeBudgets() {
+    TestRunner runner;
+    runner.addTest("Fast", []() { return true; }, std::chrono::milliseconds(1000));
+    runner.addTest("Slow", []() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return true;
+    }, std::chrono::milliseconds(5));
+    runner.addTest("Failing", []() { return false; });
+    runner.addTest("Throwing", []() -> bool {
+        throw std::runtime_error("boom");
+    });
+
+    // serial tests never overlap the parallel ones
+    std::atomic<int> active{0};
+    for (int i = 0; i < 2; i++) {
+        runner.addTest("Busy", [&active]() {
+            active++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            active--;
+            return true;
+        });
+    }
+    runner.addSerialTest("Alone", [&active]() { return active == 0; });
+
+    int failures = runner.runAll(2);
+    const std::vector<TestResult>& results = runner.getResults();
+
+    bool failureCount = ASSERT_EQ(3, failures);
+    bool fastPassed = ASSERT_EQ(true, results[0].passed);
+    bool slowOverBudget = ASSERT_EQ(true, results[1].overBudget);
+    bool slowFailed = ASSERT_EQ(false, results[1].passed);
+    bool slowTimed = ASSERT_EQ(true, results[1].elapsed >= std::chrono::milliseconds(20));
+    bool failingFailed = ASSERT_EQ(false, results[2].passed);
+    bool throwingFailed = ASSERT_EQ(false, results[3].passed);
+    bool serialAlone = ASSERT_EQ(true, results[6].passed);
+
+    return failureCount && fastPassed && slowOverBudget && slowFailed &&
+           slowTimed && failingFailed && throwingFailed && serialAlone;
+}
+
+// Latency guard: serializing a typical character must stay cheap
+bool testSerializeLatency() {
+    Character character = Character::createWarrior("Benchmark");
+    character.setStat("Constitution", 14);
+    character.addToInventory("Health Potion", 3);
+    character.addToInventory("Gold", 150);
+
+    size_t totalLength = 0;
+    for (int i = 0; i < 5000; i++) {
+        totalLength += character.serialize().size();
+    }
+
+    return ASSERT_EQ(true, totalLength > 0);
+}
+
+// Latency guard: turn processing with active effects must stay cheap
+bool testProcessTurnLatency() {
+    Character character("Benchmark", 1000000);
+
+    for (int i = 0; i < 20000; i++) {
+        character.applyStatusEffect("Poison", 3);
+        character.processTurn();
+    }
+
+    return ASSERT_EQ(1000000 - 20000 * 5, character.getHealth());
+}
+
+// Test for columnar roster snapshots and aggregate queries
+bool testRosterSnapshot() {
+    std::vector<Character> roster;
+    long long expectedGold = 0;
+    long long warriorStrength[4] = {};
+    long long warriorCount[4] = {};
+
+    // enough characters to span several column blocks
+    for (int i = 0; i < 3000; i++) {
+        Character character = i % 3 == 0 ? Character::createWarrior("W" + std::to_string(i))
+                                         : Character::createMage("M" + std::to_string(i));
+        int level = i % 4;
+        character.gainExperience(level * 100);
+        if (i % 3 == 0) {
+            character.setStat("Strength", 10 + i % 7);
+            warriorStrength[level] += 10 + i % 7;
+            warriorCount[level]++;
+        }
+        character.addToInventory("Gold", i);
+        expectedGold += i;
+        roster.push_back(character);
+    }
+
+    RosterSnapshot snapshot = RosterSnapshot::fromCharacters(roster);
+    bool rowCount = ASSERT_EQ(3000, snapshot.getRowCount());
+
+    // total gold in circulation
+    RosterQuery all(snapshot);
+    bool goldTotal = ASSERT_EQ(expectedGold, all.sum(RosterSnapshot::item("Gold")));
+    bool maxGold = ASSERT_EQ(2999, all.max(RosterSnapshot::item("Gold")));
+
+    // average strength by level across all warriors
+    RosterQuery warriors(snapshot);
+    warriors.whereEquipped("Weapon", "Longsword");
+    bool warriorTotal = ASSERT_EQ(1000, warriors.count());
+
+    std::map<int, double> strengthByLevel =
+        warriors.averageBy(RosterSnapshot::level(), RosterSnapshot::stat("Strength"));
+    bool levelsGrouped = ASSERT_EQ(4, static_cast<int>(strengthByLevel.size()));
+    bool levelTwoAverage = ASSERT_EQ(static_cast<double>(warriorStrength[1]) / warriorCount[1],
+                                     strengthByLevel[2]);
+
+    // filters combine, and unknown columns read as zero like getStat
+    RosterQuery strongHighLevel(snapshot);
+    strongHighLevel.where(RosterSnapshot::stat("Strength"), Comparison::GreaterEqual, 16)
+        .where(RosterSnapshot::level(), Comparison::Equal, 4);
+    bool combinedFilter = ASSERT_EQ(true, strongHighLevel.count() > 0 &&
+                                              strongHighLevel.min(RosterSnapshot::stat("Strength")) >= 16);
+
+    RosterQuery noCharisma(snapshot);
+    noCharisma.where(RosterSnapshot::stat("Charisma"), Comparison::Equal, 0);
+    bool missingColumnIsZero = ASSERT_EQ(3000, noCharisma.count());
+
+    RosterQuery neverEquipped(snapshot);
+    neverEquipped.whereEquipped("Weapon", "Excalibur");
+    bool unknownGearMatchesNothing = ASSERT_EQ(0, neverEquipped.count());
+
+    // snapshots survive a save/load round trip
+    RosterSnapshot loaded = RosterSnapshot::deserialize(snapshot.serialize());
+    RosterQuery loadedQuery(loaded);
+    bool roundTrip = ASSERT_EQ(expectedGold, loadedQuery.sum(RosterSnapshot::item("Gold")));
+    bool compressed = ASSERT_EQ(true, loaded.getByteSize() < 3000 * sizeof(int) * 3);
+
+    return rowCount && goldTotal && maxGold && warriorTotal && levelsGrouped &&
+           levelTwoAverage && combinedFilter && missingColumnIsZero &&
+           unknownGearMatchesNothing && roundTrip && compressed;
+}
+
+// Test for undoing mutations through the journal
+bool testMutationJournal() {
+    MutationJournal journal;
+    Character hero = Character::createWarrior("Journaled");
+    hero.addToInventory("Health Potion", 2);
+    hero.applyStatusEffect("Poison", 2);
+    std::string before = hero.serialize();
+
+    hero.attachJournal(&journal);
+    size_t mark = journal.mark();
+
+    hero.takeDamage(40);
+    hero.heal(10);
+    hero.setStat("Strength", 30);
+    hero.setStat("Wisdom", 12);
+    hero.useItem("Health Potion", 1);
+    hero.addToInventory("Journal Test Shield");
+    hero.equip("Journal Test Shield", "Offhand");
+    hero.gainExperience(250);
+    hero.setCriticalRate(0.5);
+    hero.applyStatusEffect("Poison", 5);
+    hero.processTurn();
+
+    bool mutated = ASSERT_EQ(3, hero.getLevel());
+    bool recorded = ASSERT_EQ(true, journal.size() > 0);
+
+    journal.rollback(mark);
+
+    bool healthRestored = ASSERT_EQ(100, hero.getHealth());
+    bool maxHealthRestored = ASSERT_EQ(100, hero.getMaxHealth());
+    bool levelRestored = ASSERT_EQ(1, hero.getLevel());
+    bool potionsRestored = ASSERT_EQ(2, hero.getItemCount("Health Potion"));
+    bool shieldRemoved = ASSERT_EQ(false, hero.hasItem("Journal Test Shield"));
+    bool offhandEmpty = ASSERT_EQ("", hero.getEquipped("Offhand"));
+    bool stateRestored = ASSERT_EQ(before, hero.serialize());
+    bool journalEmpty = ASSERT_EQ(0, static_cast<int>(journal.size()));
+
+    // poison ticks back to its original duration: two more turns of damage
+    hero.processTurn();
+    hero.processTurn();
+    bool poisonRestored = ASSERT_EQ(90, hero.getHealth());
+
+    // copies never write into the original's journal
+    size_t recordedBeforeCopy = journal.size();
+    Character copy = hero;
+    copy.takeDamage(10);
+    bool copyDetached = ASSERT_EQ(recordedBeforeCopy, journal.size());
+
+    return mutated && recorded && healthRestored && maxHealthRestored &&
+           levelRestored && potionsRestored && shieldRemoved && offhandEmpty &&
+           stateRestored && journalEmpty && poisonRestored && copyDetached;
+}
+
+// Test for the expectimax combat planner
+bool testCombatPlanner() {
+    Character boss("Dragon", 300);
+    boss.setStat("Strength", 25);
+    boss.learnAbility("Fire Breath", [](Character&, Character& target) {
+        target.takeDamage(30);
+        return true;
+    });
+
+    std::vector<Character> heroes;
+    heroes.push_back(Character::createWarrior("Hector"));
+    heroes.push_back(Character::createMage("Lilith"));
+    heroes[0].setStat("Strength", 20);
+    heroes[1].setStat("Strength", 5);
+    heroes[1].takeDamage(75);  // 25 health left: a basic attack kills her
+
+    CombatPlanner planner(2, 2);
+    PlannedAction best = planner.plan(boss, heroes);
+
+    // killing the weakened mage beats spreading damage
+    bool targetsMage = ASSERT_EQ(1, best.target);
+
+    // one ply: Fire Breath (30) beats a basic attack (25) on a healthy target
+    heroes[1].heal(100);
+    PlannedAction opener = CombatPlanner(1, 1).plan(boss, heroes);
+    bool usesFireBreath = ASSERT_EQ(true, opener.type == PlannedAction::Type::Ability);
+
+    // parallel and serial searches agree, and inputs are untouched
+    PlannedAction serial = CombatPlanner(3, 1).plan(boss, heroes);
+    PlannedAction parallel = CombatPlanner(3, 4).plan(boss, heroes);
+    bool sameChoice = ASSERT_EQ(serial.target, parallel.target);
+    bool sameScore = ASSERT_EQ(serial.expectedScore, parallel.expectedScore);
+    bool inputsUntouched = ASSERT_EQ(300, boss.getHealth()) &&
+                           ASSERT_EQ(100, heroes[0].getHealth());
+
+    return targetsMage && usesFireBreath && sameChoice && sameScore && inputsUntouched;
+}
+
+// Test for status effect expiry through the timing wheel
+bool testStatusEffectTimingWheel() {
+    Character character("Buffed", 1000);
+
+    // passive effects of very different lengths, including one past the
+    // wheel's top level
+    character.applyStatusEffect("Wheel Test Haste", 5);
+    character.applyStatusEffect("Wheel Test Blessing", 300);
+    character.applyStatusEffect("Wheel Test Aegis", 70000);
+    character.applyStatusEffect("Poison", 2);
+
+    bool remaining = ASSERT_EQ(300, character.getStatusEffectTurns("Wheel Test Blessing"));
+
+    for (int i = 0; i < 5; i++) {
+        character.processTurn();
+    }
+    bool hasteExpired = ASSERT_EQ(false, character.hasStatusEffect("Wheel Test Haste"));
+    bool poisonTicked = ASSERT_EQ(990, character.getHealth());  // passive effects deal nothing
+    bool blessingLeft = ASSERT_EQ(295, character.getStatusEffectTurns("Wheel Test Blessing"));
+
+    // re-applying replaces the duration
+    character.applyStatusEffect("Wheel Test Blessing", 10);
+    for (int i = 0; i < 9; i++) {
+        character.processTurn();
+    }
+    bool blessingActive = ASSERT_EQ(true, character.hasStatusEffect("Wheel Test Blessing"));
+    character.processTurn();
+    bool blessingExpired = ASSERT_EQ(false, character.hasStatusEffect("Wheel Test Blessing"));
+
+    // a zero duration clears an effect
+    character.applyStatusEffect("Wheel Test Haste", 3);
+    character.applyStatusEffect("Wheel Test Haste", 0);
+    bool cleared = ASSERT_EQ(false, character.hasStatusEffect("Wheel Test Haste"));
+
+    for (int i = 0; i < 69984; i++) {
+        character.processTurn();
+    }
+    bool aegisActive = ASSERT_EQ(1, character.getStatusEffectTurns("Wheel Test Aegis"));
+    character.processTurn();
+    bool aegisExpired = ASSERT_EQ(false, character.hasStatusEffect("Wheel Test Aegis"));
+
+    // expiries on a level boundary fire on their own turn, not one later
+    TimingWheel wheel;
+    const int boundaries[] = {16, 32, 48, 256};
+    for (int expiry : boundaries) {
+        wheel.schedule(static_cast<std::uint32_t>(expiry), expiry);
+    }
+    bool boundariesOnTime = true;
+    for (int turn = 1; turn <= 300; turn++) {
+        wheel.advanceTo(turn, [&](const TimerEntry& entry) {
+            boundariesOnTime = ASSERT_EQ(entry.expiry, turn) && boundariesOnTime;
+        });
+    }
+    bool boundariesFired = ASSERT_EQ(0, wheel.size());
+
+    // a few timers stay in a short list; more than that move into the slots
+    // and still fire on time
+    TimingWheel small;
+    small.schedule(1, 3);
+    bool listIsSmall = ASSERT_EQ(sizeof(TimerEntry), small.getHeapBytes());
+    for (int i = 2; i <= 20; i++) {
+        small.schedule(static_cast<std::uint32_t>(i), i * 7);
+    }
+    bool spilledOnTime = true;
+    int spilledFired = 0;
+    for (int turn = 1; turn <= 140; turn++) {
+        small.advanceTo(turn, [&](const TimerEntry& entry) {
+            spilledOnTime = ASSERT_EQ(entry.expiry, turn) && spilledOnTime;
+            spilledFired++;
+        });
+    }
+    bool spilledAllFired = ASSERT_EQ(20, spilledFired);
+
+    // rolling back across an expiry brings the effect back
+    MutationJournal journal;
+    character.applyStatusEffect("Poison", 1);
+    character.attachJournal(&journal);
+    int healthBefore = character.getHealth();
+    character.processTurn();
+    std::uint64_t expiredHash = character.getStateHash();
+    bool poisonGone = ASSERT_EQ(false, character.hasStatusEffect("Poison"));
+    journal.rollback(0);
+    bool poisonBack = ASSERT_EQ(1, character.getStatusEffectTurns("Poison"));
+    character.processTurn();
+    bool poisonTicksAgain = ASSERT_EQ(healthBefore - 5, character.getHealth());
+
+    // the replayed turn expires the effect again and lands on the same state
+    bool replayExpired = ASSERT_EQ(false, character.hasStatusEffect("Poison"));
+    bool replayHash = ASSERT_EQ(expiredHash, character.getStateHash());
+
+    return remaining && hasteExpired && poisonTicked && blessingLeft &&
+           blessingActive && blessingExpired && cleared && aegisActive &&
+           aegisExpired && boundariesOnTime && boundariesFired && listIsSmall &&
+           spilledOnTime && spilledAllFired && poisonGone &&
+           poisonBack && poisonTicksAgain && replayExpired && replayHash;
+}
+
+// Test that cached combat stats follow every input they depend on
+bool testDerivedStatsCache() {
+    Character character = Character::createWarrior("Cached");
+    character.setWeaponDamage("Longsword", 10);
+
+    bool initialPower = ASSERT_EQ(26, character.getDerivedStats().attackPower);
+
+    character.setStat("Strength", 20);
+    bool afterStat = ASSERT_EQ(30, character.getDerivedStats().attackPower);
+
+    character.addToInventory("Cache Test Maul");
+    ItemCatalog::global().defineItem("Cache Test Maul", 1, 15);
+    character.equip("Cache Test Maul", "Weapon");
+    bool afterEquip = ASSERT_EQ(35, character.getDerivedStats().attackPower);
+
+    // changing the catalog's base damage reaches characters already cached
+    ItemCatalog::global().defineItem("Cache Test Maul", 1, 18);
+    bool afterCatalog = ASSERT_EQ(38, character.getDerivedStats().attackPower);
+
+    character.setCriticalRate(0.25);
+    character.setCriticalMultiplier(3.0);
+    bool threshold = ASSERT_EQ(75, character.getDerivedStats().critThreshold);
+    bool multiplier = ASSERT_EQ(3.0, character.getDerivedStats().critMultiplier);
+
+    // rollbacks restore the cached numbers as well
+    MutationJournal journal;
+    character.attachJournal(&journal);
+    character.setStat("Strength", 40);
+    bool raised = ASSERT_EQ(58, character.getDerivedStats().attackPower);
+    journal.rollback(0);
+    bool rolledBack = ASSERT_EQ(38, character.getDerivedStats().attackPower);
+
+    Character target("Target", 200);
+    character.setCriticalRate(1.0);
+    character.attack(target);
+    bool criticalUsesCache = ASSERT_EQ(200 - 38 * 3, target.getHealth());
+
+    return initialPower && afterStat && afterEquip && afterCatalog && threshold &&
+           multiplier && raised && rolledBack && criticalUsesCache;
+}
+
+// Test for the batch simulation server over a unix socket
+bool testSimulationServer() {
+    std::string socketPath = "/tmp/tdd_character_test_" + std::to_string(getpid()) + ".sock";
+    SimulationServer server(socketPath, 2);
+    server.start();
+
+    Character goliath = Character::createWarrior("Goliath");
+    goliath.setStat("Strength", 20);
+
+    SimulationClient client(socketPath);
+
+    // pipeline every request before reading any result
+    const int jobCount = 2000;
+    for (int i = 0; i < jobCount; i++) {
+        SimulationRequest request(i);
+        request.addCharacter(goliath, 90);  // wounded: below its max health
+        request.addArchetype("Rogue", "Vex");
+        request.addAction("attack 0 1");                // 20 (weapon overrides are not serialized)
+        request.addAction("ability 1 0 Poison Strike"); // library ability, 16 dexterity
+        request.addAction("turn");                      // poison ticks for 5
+        request.addAction("damage 1 " + std::to_string(i % 50));
+        client.send(request);
+    }
+
+    SimulationRequest broken(jobCount);
+    broken.addArchetype("Necromancer", "Nobody");
+    client.send(broken);
+
+    std::vector<bool> seen(jobCount + 1, false);
+    bool allCorrect = true;
+    bool brokenReported = false;
+
+    for (int i = 0; i <= jobCount; i++) {
+        SimulationResult result = client.receive();
+        seen[result.id] = true;
+
+        if (result.id == static_cast<std::uint64_t>(jobCount)) {
+            brokenReported = !result.ok && !result.error.empty();
+            continue;
+        }
+
+        allCorrect = allCorrect && result.ok && result.characters.size() == 2 &&
+                     result.characters[0].health == 90 - 16 - 5 &&
+                     result.characters[0].maxHealth == goliath.getMaxHealth() &&
+                     result.characters[1].health == 100 - 20 - static_cast<int>(result.id % 50);
+    }
+
+    bool everyJobAnswered = ASSERT_EQ(true, std::find(seen.begin(), seen.end(), false) == seen.end());
+    bool outcomesCorrect = ASSERT_EQ(true, allCorrect);
+    bool errorReported = ASSERT_EQ(true, brokenReported);
+    bool jobsCounted = ASSERT_EQ(static_cast<std::uint64_t>(jobCount + 1), server.getCompletedJobs());
+
+    bool stalledIsolated = false;
+
+    // a client that stops reading only stalls its own connection: its results
+    // fill the socket, but the workers keep answering everyone else
+    {
+        SimulationClient stalled(socketPath);
+        std::thread flood([&stalled]() {
+            for (int i = 0; i < 2000; i++) {
+                SimulationRequest request(i);
+                for (int c = 0; c < 30; c++) {
+                    request.addArchetype("Mage", "Apprentice");
+                }
+                stalled.send(request);
+            }
+        });
+        flood.join();
+
+        SimulationClient other(socketPath);
+        SimulationRequest ping(jobCount + 1);
+        ping.addArchetype("Warrior", "Ping");
+        other.send(ping);
+        SimulationResult pong = other.receive();
+        stalledIsolated = ASSERT_EQ(static_cast<std::uint64_t>(jobCount + 1), pong.id) &&
+                          ASSERT_EQ(true, pong.ok);
+    }
+
+    // a known ability that declines is not replaced by the library's version,
+    // and one the library lacks does not fail the job
+    SimulationServer local(socketPath + ".local", 1);
+    Character dud("Dud", 50);
+    dud.learnAbility("Fireball", AbilityProgram::compile("fail"));
+    dud.learnAbility("Backflip", AbilityProgram::compile("fail"));
+    local.registerArchetype("Dud", dud);
+    SimulationRequest declined(jobCount + 2);
+    declined.addArchetype("Dud", "Dud");
+    declined.addArchetype("Warrior", "Target");
+    declined.addAction("ability 0 1 Fireball");
+    declined.addAction("ability 0 1 Backflip");
+    SimulationResult declinedResult = local.run(declined);
+    bool declineRespected = ASSERT_EQ(true, declinedResult.ok) &&
+                            ASSERT_EQ(100, declinedResult.characters[1].health);
+
+    // crits come from the request's own seed, so a rerun gives the same result
+    Character duelist("Duelist", 100);
+    duelist.setStat("Strength", 10);
+    duelist.setCriticalRate(0.5);
+    duelist.setCriticalMultiplier(2.0);
+    local.registerArchetype("Duelist", duelist);
+    auto duel = [&local](std::uint64_t seed) {
+        SimulationRequest request(seed);
+        request.addArchetype("Duelist", "Duelist");
+        request.addCharacter(Character("Dummy", 10000), 10000);
+        for (int i = 0; i < 40; i++) {
+            request.addAction("attack 0 1");
+        }
+        SimulationResult result = local.run(SimulationRequest::decode(request.encode()));
+        return result.ok ? result.characters[1].health : -1;
+    };
+    int firstDuel = duel(7);
+    bool seededRepeatable = ASSERT_EQ(firstDuel, duel(7)) &&
+                            ASSERT_EQ(true, firstDuel > 10000 - 800 && firstDuel < 10000 - 400);
+
+    // a payload length past the end of the frame is rejected, not allocated
+    bool oversizedRejected = false;
+    try {
+        SimulationRequest::decode("1\n1\ncharacter 100 100 4000000000\nshort");
+    } catch (const std::domain_error&) {
+        oversizedRejected = true;
+    }
+    bool lengthChecked = ASSERT_EQ(true, oversizedRejected);
+
+    server.stop();
+    bool stopped = ASSERT_EQ(false, server.isRunning());
+
+    return everyJobAnswered && outcomesCorrect && errorReported && jobsCounted &&
+           stalledIsolated && declineRespected && seededRepeatable && lengthChecked &&
+           stopped;
+}
+
+// swaps the store's log writer so the next count writes stop halfway and fail
+// as if the disk returned EIO
+class CharacterStoreTest {
+public:
+    static void failNextWrites(CharacterStore& store, int count) {
+        std::lock_guard<std::mutex> lock(store.mutex);
+        CharacterStore::LogWriter write = store.writeLog;
+        auto remaining = std::make_shared<int>(count);
+        store.writeLog = [write, remaining](int fd, const std::string& data,
+                                            const std::string& path) {
+            if (*remaining == 0) {
+                write(fd, data, path);
+                return;
+            }
+            (*remaining)--;
+            write(fd, data.substr(0, data.size() / 2), path);
+            throw std::runtime_error("write " + path + ": Input/output error");
+        };
+    }
+};
+
+bool testCharacterStore() {
+    char directoryTemplate[] = "/tmp/tdd_character_store_XXXXXX";
+    std::string directory = mkdtemp(directoryTemplate);
+
+    Character hero("Hero", 100);
+    hero.setStat("strength", 15);
+    hero.addToInventory("Potion", 3);
+    hero.addToInventory("Sword");
+    hero.equip("Sword", "weapon");
+    hero.gainExperience(150);
+
+    bool reopenedMatches = false;
+    bool concurrentSavesDurable = false;
+    bool syncsBatched = false;
+    {
+        CharacterStore store(directory);
+        store.save(hero);
+
+        // an unchanged save writes nothing
+        size_t logSize = store.getLogSize();
+        store.save(hero);
+        bool unchangedSkipped = ASSERT_EQ(logSize, store.getLogSize());
+
+        // a one-field change logs a record much smaller than the first full one
+        hero.setStat("strength", 16);
+        store.save(hero);
+        bool deltaSmall = ASSERT_EQ(true, store.getLogSize() - logSize < logSize / 2);
+
+        const int threadCount = 8;
+        const int savesPerThread = 25;
+        std::uint64_t syncsBefore = store.getSyncCount();
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadCount; t++) {
+            threads.emplace_back([&store, t]() {
+                Character member("Member " + std::to_string(t), 50);
+                for (int i = 1; i <= savesPerThread; i++) {
+                    member.setStat("dexterity", i);
+                    store.save(member);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        concurrentSavesDurable = ASSERT_EQ(threadCount + 1, store.getCharacterCount());
+        // savers that arrive while a sync is running share the next one, so
+        // concurrent saves need well under one sync each
+        std::uint64_t concurrentSyncs = store.getSyncCount() - syncsBefore;
+        syncsBatched = ASSERT_EQ(true, concurrentSyncs <= static_cast<std::uint64_t>(
+                                                              threadCount * savesPerThread / 2));
+        reopenedMatches = unchangedSkipped && deltaSmall;
+
+        // health and status effects are stored alongside what serialize carries
+        hero.takeDamage(30);
+        hero.applyStatusEffect("Poison", 3);
+        store.save(hero);
+    }
+
+    {
+        CharacterStore store(directory);
+        Character loaded = store.load("Hero");
+        reopenedMatches = reopenedMatches &&
+                          ASSERT_EQ(hero.serialize(), loaded.serialize()) &&
+                          ASSERT_EQ(hero.getHealth(), loaded.getHealth()) &&
+                          ASSERT_EQ(110, loaded.getMaxHealth()) &&
+                          ASSERT_EQ(false, loaded.isDead()) &&
+                          ASSERT_EQ(3, loaded.getStatusEffectTurns("Poison")) &&
+                          ASSERT_EQ(50, store.load("Member 3").getHealth()) &&
+                          ASSERT_EQ(25, store.load("Member 3").getStat("dexterity"));
+    }
+
+    // a torn final record is dropped on recovery
+    {
+        FILE* log = fopen((directory + "/characters.wal").c_str(), "ab");
+        fwrite("\x40\x00\x00\x00garbage", 1, 11, log);
+        fclose(log);
+    }
+
+    bool tornTailDropped = false;
+    bool compacted = false;
+    bool erased = false;
+    {
+        CharacterStore store(directory);
+        tornTailDropped = ASSERT_EQ(9, store.getCharacterCount()) &&
+                          ASSERT_EQ(16, store.load("Hero").getStat("strength"));
+
+        store.setCompactionThreshold(256);
+        for (int i = 0; i < 20; i++) {
+            hero.gainExperience(10);
+            store.save(hero);
+        }
+        compacted = ASSERT_EQ(true, store.getCompactionCount() > 0) &&
+                    ASSERT_EQ(true, store.getLogSize() < 256);
+
+        store.erase("Member 0");
+        erased = ASSERT_EQ(false, store.has("Member 0"));
+    }
+
+    {
+        CharacterStore store(directory);
+        compacted = compacted && ASSERT_EQ(hero.serialize(), store.load("Hero").serialize());
+        erased = erased && ASSERT_EQ(false, store.has("Member 0")) &&
+                 ASSERT_EQ(8, store.getCharacterCount());
+
+        bool missingThrows = false;
+        try {
+            store.load("Member 0");
+        } catch (const std::domain_error&) {
+            missingThrows = true;
+        }
+        erased = erased && ASSERT_EQ(true, missingThrows);
+    }
+
+    // a failed write acknowledges nothing, leaves no torn record behind, and
+    // a retried save logs its change again
+    bool failureHandled = false;
+    const int faultyCount = 8;
+    std::vector<int> faultySaved(faultyCount, 0);
+    {
+        CharacterStore store(directory);
+        size_t logSize = store.getLogSize();
+        CharacterStoreTest::failNextWrites(store, 1);
+
+        hero.setStat("strength", 40);
+        bool saveFailed = false;
+        try {
+            store.save(hero);
+        } catch (const std::runtime_error&) {
+            saveFailed = true;
+        }
+        failureHandled =
+            ASSERT_EQ(true, saveFailed) && ASSERT_EQ(logSize, store.getLogSize()) &&
+            ASSERT_EQ(logSize, std::filesystem::file_size(directory + "/characters.wal")) &&
+            ASSERT_EQ(16, store.load("Hero").getStat("strength"));
+
+        store.save(hero);
+        failureHandled = failureHandled && ASSERT_EQ(40, store.load("Hero").getStat("strength"));
+
+        // savers grouped with a failed write all fail; the rest are durable
+        CharacterStoreTest::failNextWrites(store, 1);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < faultyCount; t++) {
+            threads.emplace_back([&store, &faultySaved, t]() {
+                try {
+                    store.save(Character("Faulty " + std::to_string(t), 10));
+                    faultySaved[t] = 1;
+                } catch (const std::runtime_error&) {
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        failureHandled = failureHandled &&
+                         ASSERT_EQ(true, std::count(faultySaved.begin(), faultySaved.end(), 1) <
+                                             faultyCount);
+    }
+
+    {
+        CharacterStore store(directory);
+        failureHandled = failureHandled && ASSERT_EQ(40, store.load("Hero").getStat("strength"));
+        for (int t = 0; t < faultyCount; t++) {
+            failureHandled = failureHandled && ASSERT_EQ(faultySaved[t] == 1,
+                                                         store.has("Faulty " + std::to_string(t)));
+        }
+    }
+
+    std::filesystem::remove_all(directory);
+
+    return reopenedMatches && concurrentSavesDurable && syncsBatched && tornTailDropped &&
+           compacted && erased && failureHandled;
+}
+
+bool testStateHashing() {
+    Character primary = Character::createWarrior("Primary");
+    primary.addToInventory("Potion", 3);
+    primary.setCriticalRate(0.29);
+    primary.setCriticalMultiplier(1.5);
+    primary.setWeaponDamage("Longsword", 5);
+
+    Character shadow = primary;
+    Character enemy = Character::createRogue("Enemy");
+    Character shadowEnemy = enemy;
+
+    // lockstep: both sides apply the same moves and compare every turn
+    bool lockstepMatches = true;
+    bool incrementalMatches = true;
+    for (int turn = 0; turn < 20; turn++) {
+        bool critical = turn % 3 == 0;
+        primary.resolveAttack(enemy, critical);
+        shadow.resolveAttack(shadowEnemy, critical);
+
+        if (turn % 4 == 0) {
+            enemy.applyStatusEffect("Poison", 2);
+            shadowEnemy.applyStatusEffect("Poison", 2);
+            primary.useItem("Potion", 1);
+            shadow.useItem("Potion", 1);
+        }
+
+        enemy.heal(10);
+        shadowEnemy.heal(10);
+        for (Character* character : {&primary, &shadow, &enemy, &shadowEnemy}) {
+            character->processTurn();
+            incrementalMatches = incrementalMatches &&
+                                 character->getStateHash() == character->computeStateHash();
+        }
+
+        lockstepMatches = lockstepMatches &&
+                          primary.getStateHash() == shadow.getStateHash() &&
+                          enemy.getStateHash() == shadowEnemy.getStateHash();
+    }
+
+    bool inLockstep = ASSERT_EQ(true, lockstepMatches);
+    bool incremental = ASSERT_EQ(true, incrementalMatches);
+
+    // a single diverging hit is detected
+    shadowEnemy.takeDamage(1);
+    bool desyncDetected = ASSERT_EQ(true, enemy.getStateHash() != shadowEnemy.getStateHash());
+
+    // undoing a change restores the exact hash
+    std::uint64_t before = primary.getStateHash();
+    MutationJournal journal;
+    primary.attachJournal(&journal);
+    size_t mark = journal.mark();
+    primary.gainExperience(250);
+    primary.setStat("Strength", 30);
+    primary.equip("Potion", "Offhand");
+    primary.setWeaponDamage("Axe", 9);
+    primary.applyStatusEffect("Haste", 3);
+    primary.processTurn();
+    bool changed = ASSERT_EQ(true, primary.getStateHash() != before);
+    journal.rollback(mark);
+    primary.attachJournal(nullptr);
+    bool restored = ASSERT_EQ(before, primary.getStateHash()) &&
+                    ASSERT_EQ(before, primary.computeStateHash());
+
+    // inventory order does not matter
+    Character first("Twin", 100);
+    first.addToInventory("Arrow", 20);
+    first.addToInventory("Bread", 2);
+    Character second("Twin", 100);
+    second.addToInventory("Bread", 2);
+    second.addToInventory("Arrow", 20);
+    bool orderIndependent = ASSERT_EQ(first.getStateHash(), second.getStateHash());
+
+    // crit math is fixed-point: 0.29 is exactly 29%, 15 * 1.5 truncates to 22
+    Character striker("Striker", 100);
+    striker.setStat("Strength", 15);
+    striker.setCriticalRate(0.29);
+    striker.setCriticalMultiplier(1.5);
+    Character dummy("Dummy", 100);
+    striker.resolveAttack(dummy, true);
+    bool fixedPoint = ASSERT_EQ(71, striker.getDerivedStats().critThreshold) &&
+                      ASSERT_EQ(22, striker.getDerivedStats().critDamage) &&
+                      ASSERT_EQ(78, dummy.getHealth());
+
+    Party party("Heroes");
+    std::uint64_t emptyParty = party.getStateHash();
+    party.addMember(Character::createWarrior("Aria"));
+    party.addMember(Character::createMage("Bram"));
+    std::uint64_t fullParty = party.getStateHash();
+    party.updateMember("Bram", [](Character& member) { member.takeDamage(10); });
+    bool partyTracksMembers = ASSERT_EQ(true, party.getStateHash() != fullParty) &&
+                              ASSERT_EQ(party.computeStateHash(), party.getStateHash());
+    party.updateMember("Bram", [](Character& member) { member.heal(10); });
+    bool partyRestored = ASSERT_EQ(fullParty, party.getStateHash());
+    party.removeMember("Aria");
+    party.removeMember("Bram");
+    partyRestored = partyRestored && ASSERT_EQ(emptyParty, party.getStateHash());
+
+    return inLockstep && incremental && desyncDetected && changed && restored &&
+           orderIndependent && fixedPoint && partyTracksMembers && partyRestored;
+}
+
+bool testMemoryAccounting() {
+    Character bare("Bare", 100);
+    CharacterMemoryUsage empty = bare.getMemoryUsage();
+    bool bareIsObjectOnly = ASSERT_EQ(sizeof(Character), empty.total());
+
+    Character hero("A name far too long for the small string buffer", 100);
+    hero.setStat("Strength", 10);
+    hero.setStat("Dexterity", 12);
+    for (int i = 0; i < 6; i++) {
+        hero.addToInventory("Trinket " + std::to_string(i));
+    }
+    hero.equip("Trinket 0", "Neck");
+    hero.setWeaponDamage("Trinket 0", 3);
+    hero.applyStatusEffect("Poison", 3);
+    hero.learnAbility("Jab", [](Character&, Character& target) {
+        target.takeDamage(1);
+        return true;
+    });
+
+    CharacterMemoryUsage usage = hero.getMemoryUsage();
+    bool componentsCounted =
+        ASSERT_EQ(true, usage.name > 0) &&
+        ASSERT_EQ(true, usage.stats >= 2 * memory::MAP_NODE_OVERHEAD) &&
+        ASSERT_EQ(true, usage.inventory >= 6 * sizeof(ItemStack)) &&
+        ASSERT_EQ(true, usage.gear >= memory::MAP_NODE_OVERHEAD) &&
+        ASSERT_EQ(true, usage.weaponTable >= memory::MAP_NODE_OVERHEAD) &&
+        ASSERT_EQ(true, usage.abilities >= memory::MAP_NODE_OVERHEAD) &&
+        ASSERT_EQ(true, usage.statusEffects > 0) &&
+        ASSERT_EQ(1, usage.opaqueAbilities);
+
+    bool partsAddUp = ASSERT_EQ(usage.object + usage.name + usage.stats + usage.inventory +
+                                    usage.gear + usage.weaponTable + usage.abilities +
+                                    usage.statusEffects,
+                                usage.total());
+
+    Party party("Heroes");
+    party.addMember(hero);
+    party.addMember(bare);
+    PartyMemoryUsage partyUsage = party.getMemoryUsage();
+    bool partyCounted =
+        ASSERT_EQ(2, partyUsage.memberCount) &&
+        ASSERT_EQ(usage.total() + empty.total(), partyUsage.members.total()) &&
+        ASSERT_EQ(true, partyUsage.total() > partyUsage.members.total());
+
+    RosterMemorySummary summary = RosterMemorySummary::summarize({bare, hero});
+    std::string report = summary.report();
+    bool summarized = ASSERT_EQ(2, summary.characterCount) &&
+                      ASSERT_EQ(usage.total() + empty.total(), summary.totals.total()) &&
+                      ASSERT_EQ(hero.getName(), summary.largestName) &&
+                      ASSERT_EQ(true, report.find("weapon table") != std::string::npos);
+
+    return bareIsObjectOnly && componentsCounted && partsAddUp && partyCounted && summarized;
+}
+
+bool testPartySerialization() {
+    Party party("Caravan Guard");
+    std::vector<Character> members;
+
+    for (int i = 0; i < 40; i++) {
+        Character member = i % 3 == 0   ? Character::createWarrior("Guard " + std::to_string(i))
+                           : i % 3 == 1 ? Character::createMage("Guard " + std::to_string(i))
+                                        : Character::createRogue("Guard " + std::to_string(i));
+        member.setStat("Constitution", 10 + i % 5);
+        member.addToInventory("Health Potion", 1 + i % 4);
+        member.addToInventory("Travel Rations", 3);
+        member.gainExperience(i * 37);
+        member.takeDamage(i % 25);
+        party.addMember(member);
+        members.push_back(member);
+    }
+
+    std::string blob = party.serialize();
+    Party loaded = Party::deserialize(blob);
+
+    bool sameHash = ASSERT_EQ(party.getStateHash(), loaded.getStateHash()) &&
+                    ASSERT_EQ(40, loaded.getMemberCount());
+
+    // health survives even though Character::serialize drops it
+    bool membersMatch = true;
+    for (auto& member : members) {
+        std::string expected = member.serialize();
+        int health = member.getHealth();
+        loaded.updateMember(member.getName(), [&](Character& restored) {
+            membersMatch = membersMatch && restored.serialize() == expected &&
+                           restored.getHealth() == health;
+        });
+    }
+    bool restored = ASSERT_EQ(true, membersMatch);
+
+    size_t textBytes = 0;
+    for (const auto& member : members) {
+        textBytes += member.serialize().size();
+    }
+    bool compact = ASSERT_EQ(true, blob.size() * 3 < textBytes);
+
+    bool emptyRoundTrips = ASSERT_EQ(Party("Nobody").getStateHash(),
+                                     Party::deserialize(Party("Nobody").serialize()).getStateHash());
+
+    bool corruptRejected = false;
+    try {
+        Party::deserialize(blob.substr(0, blob.size() / 2));
+    } catch (const std::domain_error&) {
+        corruptRejected = true;
+    }
+    bool rejected = ASSERT_EQ(true, corruptRejected);
+
+    return sameHash && restored && compact && emptyRoundTrips && rejected;
+}
+
+bool testAbilityScript() {
+    auto fireball = AbilityProgram::compile("damage target caster.Intelligence * 2");
+
+    Character mage = Character::createMage("Merlin");
+    mage.learnAbility("Fireball", fireball);
+    Character goblin("Goblin", 100);
+    bool used = ASSERT_EQ(true, mage.useAbility("Fireball", goblin));
+    bool damaged = ASSERT_EQ(100 - 32, goblin.getHealth());
+
+    // conditionals, stat writes, quoted names and built-ins
+    auto arcaneBolt = AbilityProgram::compile(
+        "# costs 10 mana\n"
+        "if caster.Mana < 10\n"
+        "    fail\n"
+        "end\n"
+        "set caster Mana caster.Mana - 10\n"
+        "if target has Poison\n"
+        "    damage target caster.\"Spell Power\" + caster.level * 2\n"
+        "else\n"
+        "    status target Poison 2\n"
+        "end\n");
+    mage.learnAbility("Arcane Bolt", arcaneBolt);
+    mage.setStat("Mana", 15);
+    mage.setStat("Spell Power", 7);
+
+    Character orc("Orc", 100);
+    bool firstCast = ASSERT_EQ(true, mage.useAbility("Arcane Bolt", orc)) &&
+                     ASSERT_EQ(true, orc.hasStatusEffect("Poison")) &&
+                     ASSERT_EQ(100, orc.getHealth()) &&
+                     ASSERT_EQ(5, mage.getStat("Mana"));
+    bool outOfMana = ASSERT_EQ(false, mage.useAbility("Arcane Bolt", orc));
+    mage.setStat("Mana", 10);
+    bool secondCast = ASSERT_EQ(true, mage.useAbility("Arcane Bolt", orc)) &&
+                      ASSERT_EQ(100 - 9, orc.getHealth());
+
+    // one program over a whole batch of targets
+    auto fireBreath = AbilityProgram::compile("damage target 30 - target.level");
+    std::vector<Character> villagers;
+    for (int i = 0; i < 6; i++) {
+        villagers.push_back(Character("Villager " + std::to_string(i), 50));
+    }
+    std::vector<Character*> targets;
+    for (auto& villager : villagers) {
+        targets.push_back(&villager);
+    }
+    Character dragon("Dragon", 300);
+    int hits = fireBreath->runBatch(dragon, targets);
+    bool batch = ASSERT_EQ(6, hits) && ASSERT_EQ(50 - 29, villagers[5].getHealth());
+
+    bool profiled = ASSERT_EQ(static_cast<std::uint64_t>(6), fireBreath->getRunCount()) &&
+                    ASSERT_EQ(true, fireBreath->getInstructionCount() >= 6 * 4);
+
+    std::string listing = fireball->disassemble();
+    bool inspectable =
+        ASSERT_EQ(true, listing.find("load_stat caster \"Intelligence\"") != std::string::npos);
+
+    int rejected = 0;
+    std::string nested = "damage target 1";
+    for (int i = 0; i < AbilityProgram::MAX_STACK + 1; i++) {
+        nested += " + (1";
+    }
+    nested += std::string(AbilityProgram::MAX_STACK + 1, ')');
+    for (const char* source : {"damage enemy 5", "if caster.Mana > 1\ndamage target 1",
+                               "end", "explode target", "damage target (1 + 2"}) {
+        try {
+            AbilityProgram::compile(source);
+        } catch (const std::domain_error& error) {
+            rejected += std::string(error.what()).find("line") == 0 ? 1 : 0;
+        }
+    }
+    try {
+        AbilityProgram::compile(nested);
+    } catch (const std::domain_error&) {
+        rejected++;
+    }
+    bool errorsReported = ASSERT_EQ(6, rejected);
+
+    // scripted abilities survive a party save; native ones are dropped
+    Character healer = Character::createMage("Healer");
+    healer.learnAbility("Mend", AbilityProgram::compile("heal target caster.Intelligence"));
+    healer.learnAbility("Wave", [](Character&, Character&) { return true; });
+    Party party("Menders");
+    party.addMember(healer);
+    Party loaded = Party::deserialize(party.serialize());
+
+    bool saved = false;
+    loaded.updateMember("Healer", [&](Character& member) {
+        Character patient("Patient", 100);
+        patient.takeDamage(40);
+        saved = member.getAbilityNames() == std::vector<std::string>{"Mend"} &&
+                member.useAbility("Mend", patient) && patient.getHealth() == 76;
+    });
+    bool savable = ASSERT_EQ(true, saved);
+
+    // compiled reads go through stat ids, which follow every way a stat changes
+    StatId wisdom = StatRegistry::global().idFor("Wisdom");
+    Character sage("Sage", 50);
+    bool unsetIsZero = ASSERT_EQ(0, sage.getStat(wisdom));
+    MutationJournal journal;
+    sage.attachJournal(&journal);
+    sage.setStat("Wisdom", 7);
+    bool idSet = ASSERT_EQ(7, sage.getStat(wisdom));
+    sage.setStat(wisdom, 9);
+    bool nameSet = ASSERT_EQ(9, sage.getStat("Wisdom"));
+    journal.rollback(0);
+    bool idReverted = ASSERT_EQ(0, sage.getStat(wisdom));
+    sage.attachJournal(nullptr);
+    sage.setStat("Wisdom", 11);
+    bool idDeserialized = ASSERT_EQ(11, Character::deserialize(sage.serialize()).getStat(wisdom));
+    bool statIds = unsetIsZero && idSet && nameSet && idReverted && idDeserialized;
+
+    return used && damaged && firstCast && outOfMana && secondCast && batch && profiled &&
+           inspectable && errorsReported && savable && statIds;
+}
+
+bool testPartySnapshots() {
+    Party party("Vanguard");
+    for (int i = 0; i < 8; i++) {
+        party.addMember(Character("Member " + std::to_string(i), 1000));
+    }
+
+    PartyPublisher publisher;
+    bool emptyBeforePublish = ASSERT_EQ(true, publisher.read().get() == nullptr);
+
+    publisher.publish(party);
+
+    // a held snapshot is not reclaimed and does not change under the reader
+    bool pinnedSafely = false;
+    {
+        PartyPublisher::ReadGuard pinned = publisher.read();
+        party.updateMember("Member 3", [](Character& member) { member.takeDamage(100); });
+        publisher.publish(party);
+        publisher.publish(party);
+
+        pinnedSafely = ASSERT_EQ(static_cast<std::uint64_t>(1), pinned->version) &&
+                       ASSERT_EQ(1000, pinned->find("Member 3")->health) &&
+                       ASSERT_EQ(true, publisher.getRetiredCount() >= 1);
+    }
+    publisher.publish(party);
+    bool reclaimed = ASSERT_EQ(static_cast<size_t>(0), publisher.getRetiredCount());
+
+    bool latest = false;
+    {
+        PartyPublisher::ReadGuard guard = publisher.read();
+        latest = ASSERT_EQ(static_cast<std::uint64_t>(4), guard->version) &&
+                 ASSERT_EQ(900, guard->find("Member 3")->health) &&
+                 ASSERT_EQ(party.getStateHash(), guard->stateHash) &&
+                 ASSERT_EQ(true, guard->find("Nobody") == nullptr);
+    }
+
+    party.updateMember("Member 3", [](Character& member) { member.heal(100); });
+    publisher.publish(party);
+
+    // every turn the writer hits each member once, so within any one snapshot
+    // all members must show the same health
+    std::atomic<bool> done{false};
+    std::atomic<int> tornSnapshots{0};
+    std::atomic<int> reads{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; r++) {
+        readers.emplace_back([&]() {
+            std::uint64_t lastVersion = 0;
+            while (!done.load()) {
+                PartyPublisher::ReadGuard guard = publisher.read();
+                const PartySnapshot& snapshot = *guard;
+
+                bool consistent = snapshot.members.size() == 8 && snapshot.version >= lastVersion;
+                for (const auto& member : snapshot.members) {
+                    consistent = consistent && member.health == snapshot.members[0].health;
+                }
+                if (!consistent) {
+                    tornSnapshots++;
+                }
+
+                lastVersion = snapshot.version;
+                reads++;
+            }
+        });
+    }
+
+    for (int turn = 0; turn < 500; turn++) {
+        for (int i = 0; i < 8; i++) {
+            party.updateMember("Member " + std::to_string(i), [](Character& member) {
+                member.takeDamage(member.getHealth() > 1 ? 1 : 0);
+            });
+        }
+        publisher.publish(party);
+    }
+
+    // on a single core the readers may not have been scheduled yet
+    while (reads.load() == 0) {
+        std::this_thread::yield();
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    bool noTearing = ASSERT_EQ(0, tornSnapshots.load()) && ASSERT_EQ(true, reads.load() > 0);
+
+    publisher.publish(party);
+    bool drained = ASSERT_EQ(static_cast<size_t>(0), publisher.getRetiredCount());
+
+    return emptyBeforePublish && pinnedSafely && reclaimed && latest && noTearing && drained;
+}
\ No newline at end of file
@@ -21,4 +21,21 @@ bool testCombatModifiers();
 bool testStackableInventory();
 bool testPartyMechanics();
 bool testCharacterSerialization();
-bool testCompleteBattleScenario();
\ No newline at end of file
+bool testCompleteBattleScenario();
+bool testItemCatalog();
+bool testTestRunnerTimeBudgets();
+bool testSerializeLatency();
+bool testProcessTurnLatency();
+bool testRosterSnapshot();
+bool testMutationJournal();
+bool testCombatPlanner();
+bool testStatusEffectTimingWheel();
+bool testDerivedStatsCache();
+bool testSimulationServer();
+bool testCharacterStore();
+
+bool testStateHashing();
+bool testMemoryAccounting();
+bool testPartySerialization();
+bool testAbilityScript();
+bool testPartySnapshots();
\ No newline at end of file
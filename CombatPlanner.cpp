@@ -0,0 +1,226 @@
+#include "CombatPlanner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+const double DEATH_PENALTY = 100000.0;
+const double KILL_BONUS = 1000.0;
+
+// one search thread's private copy of the encounter
+class Search {
+private:
+    Character actor;
+    std::vector<Character> enemies;
+    MutationJournal journal{};
+
+    bool isOver() {
+        if (actor.isDead()) {
+            return true;
+        }
+
+        for (auto& enemy : enemies) {
+            if (!enemy.isDead()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // probability-weighted outcomes of attacker hitting defender, continuing
+    // with next afterwards
+    template <typename Next>
+    double chanceAttack(Character& attacker, Character& defender, Next next) {
+        double critRate = std::min(1.0, std::max(0.0, attacker.getCriticalRate()));
+        double expected = 0.0;
+
+        if (critRate > 0.0) {
+            size_t mark = journal.mark();
+            attacker.resolveAttack(defender, true);
+            expected += critRate * next();
+            journal.rollback(mark);
+        }
+
+        if (critRate < 1.0) {
+            size_t mark = journal.mark();
+            attacker.resolveAttack(defender, false);
+            expected += (1.0 - critRate) * next();
+            journal.rollback(mark);
+        }
+
+        return expected;
+    }
+
+    double endRound(int depth) {
+        actor.processTurn();
+        for (auto& enemy : enemies) {
+            enemy.processTurn();
+        }
+
+        return maxNode(depth - 1);
+    }
+
+    double enemyResponse(size_t index, int depth) {
+        while (index < enemies.size() && enemies[index].isDead()) {
+            index++;
+        }
+
+        if (actor.isDead()) {
+            return CombatPlanner::evaluate(actor, enemies);
+        }
+
+        if (index == enemies.size()) {
+            return endRound(depth);
+        }
+
+        return chanceAttack(enemies[index], actor,
+                            [this, index, depth]() { return enemyResponse(index + 1, depth); });
+    }
+
+public:
+    Search(const Character& actor, const std::vector<Character>& enemies)
+        : actor{actor}, enemies{enemies} {
+        this->actor.attachJournal(&journal);
+        for (auto& enemy : this->enemies) {
+            enemy.attachJournal(&journal);
+        }
+    }
+
+    std::vector<PlannedAction> rootActions() {
+        return CombatPlanner::listActions(actor, enemies);
+    }
+
+    // expected score of taking action now, followed by depth - 1 more rounds
+    double actionValue(const PlannedAction& action, int depth) {
+        size_t mark = journal.mark();
+        double value;
+
+        if (action.type == PlannedAction::Type::Attack) {
+            value = chanceAttack(actor, enemies[action.target],
+                                 [this, depth]() { return enemyResponse(0, depth); });
+        } else if (actor.useAbility(action.ability, enemies[action.target])) {
+            value = enemyResponse(0, depth);
+        } else {
+            value = -std::numeric_limits<double>::infinity();
+        }
+
+        journal.rollback(mark);
+        return value;
+    }
+
+    double maxNode(int depth) {
+        if (depth <= 0 || isOver()) {
+            return CombatPlanner::evaluate(actor, enemies);
+        }
+
+        double best = -std::numeric_limits<double>::infinity();
+        for (const auto& action : CombatPlanner::listActions(actor, enemies)) {
+            best = std::max(best, actionValue(action, depth));
+        }
+
+        return best;
+    }
+};
+}  // namespace
+
+CombatPlanner::CombatPlanner(int depth, unsigned threads)
+    : depth{depth}, threadCount{threads} {}
+
+std::vector<PlannedAction> CombatPlanner::listActions(Character& actor,
+                                                      std::vector<Character>& enemies) {
+    std::vector<PlannedAction> actions;
+    std::vector<std::string> abilities = actor.getAbilityNames();
+
+    for (size_t i = 0; i < enemies.size(); i++) {
+        if (enemies[i].isDead()) {
+            continue;
+        }
+
+        PlannedAction attack{};
+        attack.target = static_cast<int>(i);
+        actions.push_back(attack);
+
+        for (const auto& ability : abilities) {
+            PlannedAction use{};
+            use.type = PlannedAction::Type::Ability;
+            use.ability = ability;
+            use.target = static_cast<int>(i);
+            actions.push_back(use);
+        }
+    }
+
+    return actions;
+}
+
+double CombatPlanner::evaluate(Character& actor, std::vector<Character>& enemies) {
+    if (actor.isDead()) {
+        return -DEATH_PENALTY;
+    }
+
+    double score = actor.getHealth();
+    for (auto& enemy : enemies) {
+        score -= enemy.getHealth();
+        if (enemy.isDead()) {
+            score += KILL_BONUS;
+        }
+    }
+
+    return score;
+}
+
+PlannedAction CombatPlanner::plan(const Character& actor,
+                                  const std::vector<Character>& enemies) const {
+    std::vector<PlannedAction> actions = Search(actor, enemies).rootActions();
+    if (actions.empty()) {
+        throw std::domain_error("no actions available to plan");
+    }
+
+    unsigned workers = threadCount != 0 ? threadCount
+                                        : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min<unsigned>(workers, static_cast<unsigned>(actions.size()));
+
+    // root actions are independent, so each worker gets its own copy of the
+    // encounter and pulls actions until none are left
+    std::atomic<size_t> nextAction{0};
+    std::vector<std::exception_ptr> errors(workers);
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < workers; i++) {
+        threads.emplace_back([&, i]() {
+            try {
+                Search search(actor, enemies);
+                for (size_t index = nextAction++; index < actions.size();
+                     index = nextAction++) {
+                    actions[index].expectedScore = search.actionValue(actions[index], depth);
+                }
+            } catch (...) {
+                // abilities are user code; hand their exceptions to the caller
+                errors[i] = std::current_exception();
+                nextAction = actions.size();
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // ties go to the earliest action so the result does not depend on timing
+    PlannedAction best = actions.front();
+    for (const auto& action : actions) {
+        if (action.expectedScore > best.expectedScore) {
+            best = action;
+        }
+    }
+
+    return best;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "character.h"
+
+struct PlannedAction {
+    enum class Type { Attack, Ability };
+
+    Type type{Type::Attack};
+    std::string ability{};
+    int target{-1};
+    double expectedScore{};
+};
+
+// depth-limited expectimax for one character fighting a group of enemies.
+// each round the actor picks an action (max node), critical hits are chance
+// nodes weighted by the attacker's crit rate, every living enemy answers with
+// a basic attack and status effects tick. moves are applied and taken back
+// through a MutationJournal instead of copying characters per node.
+class CombatPlanner {
+private:
+    int depth{};
+    unsigned threadCount{};
+
+public:
+    // threads = 0 uses one thread per core for the root actions
+    explicit CombatPlanner(int depth, unsigned threads = 0);
+
+    // actor's candidate moves: attack each living enemy, and use each ability
+    // on each living enemy
+    static std::vector<PlannedAction> listActions(Character& actor,
+                                                  std::vector<Character>& enemies);
+
+    // higher is better for the actor
+    static double evaluate(Character& actor, std::vector<Character>& enemies);
+
+    // best action for actor, searching root actions in parallel. actor and
+    // enemies are left untouched.
+    PlannedAction plan(const Character& actor, const std::vector<Character>& enemies) const;
+};
@@ -1,6 +1,36 @@
 #pragma once
+#include <cmath>
+#include <cstdint>
 
+// combat ratios are fixed-point with FIXED_POINT_SCALE units per 1.0 so damage
+// and crit math is plain integer arithmetic and gives the same result on every
+// build and compiler. doubles are converted once, when a setting is changed.
+constexpr std::int64_t FIXED_POINT_SCALE = 10000;
+
+inline int toFixedPoint(double value) {
+    return static_cast<int>(std::llround(value * FIXED_POINT_SCALE));
+}
+
+inline double fromFixedPoint(int value) {
+    return static_cast<double>(value) / FIXED_POINT_SCALE;
+}
+
+// value * ratio, truncated toward zero like the integer damage it feeds
+inline int applyFixedPoint(int value, int ratio) {
+    return static_cast<int>(static_cast<std::int64_t>(value) * ratio / FIXED_POINT_SCALE);
+}
+
+// both fields are fixed-point
 struct CriticalHitSettings {
-    double rate{};
-    double modifier{};
-};
\ No newline at end of file
+    int rate{};
+    int modifier{};
+};
+
+// combat numbers derived from stats, gear and crit settings. cached on the
+// character and rebuilt only after one of their inputs changes.
+struct DerivedStats {
+    int attackPower{};
+    int critThreshold{};  // d100 rolls above this are critical hits
+    double critMultiplier{};
+    int critDamage{};     // attackPower scaled by the fixed-point multiplier
+};
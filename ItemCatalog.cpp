@@ -0,0 +1,108 @@
+#include "ItemCatalog.h"
+
+#include <mutex>
+#include <stdexcept>
+
+#include "StateHash.h"
+
+ItemCatalog& ItemCatalog::global() {
+    static ItemCatalog catalog;
+    return catalog;
+}
+
+ItemId ItemCatalog::defineItem(const std::string& name, int stackLimit,
+                               int weaponDamage) {
+    if (stackLimit < 1) {
+        throw std::domain_error("item stack limit must be at least 1");
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+
+    auto it = idsByName.find(name);
+    if (it != idsByName.end()) {
+        definitions[it->second].stackLimit = stackLimit;
+        definitions[it->second].weaponDamage = weaponDamage;
+        version++;
+        return it->second;
+    }
+
+    ItemId id = static_cast<ItemId>(definitions.size());
+    definitions.push_back({name, stackLimit, weaponDamage, statehash::ofString(name)});
+    idsByName[name] = id;
+
+    return id;
+}
+
+ItemId ItemCatalog::idFor(const std::string& name) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = idsByName.find(name);
+        if (it != idsByName.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+
+    // another thread may have registered it between the two locks
+    auto it = idsByName.find(name);
+    if (it != idsByName.end()) {
+        return it->second;
+    }
+
+    ItemId id = static_cast<ItemId>(definitions.size());
+    ItemDefinition definition{};
+    definition.name = name;
+    definition.hashKey = statehash::ofString(name);
+    definitions.push_back(definition);
+    idsByName[name] = id;
+
+    return id;
+}
+
+bool ItemCatalog::find(const std::string& name, ItemId& id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+
+    auto it = idsByName.find(name);
+    if (it == idsByName.end()) {
+        return false;
+    }
+
+    id = it->second;
+    return true;
+}
+
+ItemDefinition ItemCatalog::get(ItemId id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+
+    if (id >= definitions.size()) {
+        throw std::out_of_range("unknown item id");
+    }
+
+    return definitions[id];
+}
+
+std::string ItemCatalog::nameOf(ItemId id) const { return get(id).name; }
+
+int ItemCatalog::stackLimitOf(ItemId id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return id < definitions.size() ? definitions[id].stackLimit
+                                   : std::numeric_limits<int>::max();
+}
+
+int ItemCatalog::weaponDamageOf(ItemId id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return id < definitions.size() ? definitions[id].weaponDamage : 0;
+}
+
+std::uint64_t ItemCatalog::hashKeyOf(ItemId id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return id < definitions.size() ? definitions[id].hashKey : 0;
+}
+
+std::uint64_t ItemCatalog::getVersion() const { return version; }
+
+int ItemCatalog::getItemCount() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return static_cast<int>(definitions.size());
+}
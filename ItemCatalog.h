@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+using ItemId = std::uint32_t;
+
+struct ItemDefinition {
+    std::string name{};
+    int stackLimit{std::numeric_limits<int>::max()};
+    int weaponDamage{};
+    // statehash::ofString(name), cached for incremental state hashing
+    std::uint64_t hashKey{};
+};
+
+// one (item, count) entry of a character's inventory
+struct ItemStack {
+    ItemId item{};
+    int count{};
+};
+
+// process-wide registry of every item the game knows about. items are given a
+// dense id the first time they are seen so characters can store ids instead of
+// names.
+class ItemCatalog {
+private:
+    mutable std::shared_mutex mutex{};
+    std::deque<ItemDefinition> definitions{};
+    std::unordered_map<std::string, ItemId> idsByName{};
+    std::atomic<std::uint64_t> version{};
+
+public:
+    static ItemCatalog& global();
+
+    // registers a new item or updates the static data of an existing one
+    ItemId defineItem(const std::string& name, int stackLimit, int weaponDamage = 0);
+
+    // returns the id for name, registering it with default data if unknown
+    ItemId idFor(const std::string& name);
+
+    // looks up name without registering it
+    bool find(const std::string& name, ItemId& id) const;
+
+    ItemDefinition get(ItemId id) const;
+    std::string nameOf(ItemId id) const;
+    int stackLimitOf(ItemId id) const;
+    int weaponDamageOf(ItemId id) const;
+    std::uint64_t hashKeyOf(ItemId id) const;
+    int getItemCount() const;
+    // bumped whenever the data of an existing item changes
+    std::uint64_t getVersion() const;
+};
@@ -0,0 +1,78 @@
+#include "MemoryUsage.h"
+
+#include <iomanip>
+#include <sstream>
+
+#include "character.h"
+
+size_t CharacterMemoryUsage::total() const {
+    return object + name + stats + inventory + gear + weaponTable + abilities +
+           statusEffects;
+}
+
+CharacterMemoryUsage& CharacterMemoryUsage::operator+=(const CharacterMemoryUsage& other) {
+    object += other.object;
+    name += other.name;
+    stats += other.stats;
+    inventory += other.inventory;
+    gear += other.gear;
+    weaponTable += other.weaponTable;
+    abilities += other.abilities;
+    statusEffects += other.statusEffects;
+    opaqueAbilities += other.opaqueAbilities;
+    return *this;
+}
+
+size_t PartyMemoryUsage::total() const {
+    return object + name + memberNodes + members.total();
+}
+
+RosterMemorySummary RosterMemorySummary::summarize(const std::vector<Character>& roster) {
+    RosterMemorySummary summary;
+
+    for (const auto& character : roster) {
+        CharacterMemoryUsage usage = character.getMemoryUsage();
+        summary.totals += usage;
+        summary.characterCount++;
+
+        if (usage.total() > summary.largest) {
+            summary.largest = usage.total();
+            summary.largestName = character.getName();
+        }
+    }
+
+    return summary;
+}
+
+std::string RosterMemorySummary::report() const {
+    std::stringstream ss;
+    ss << "characters: " << characterCount << '\n';
+
+    auto row = [&](const char* label, size_t bytes) {
+        size_t average = characterCount > 0 ? bytes / characterCount : 0;
+        ss << std::left << std::setw(16) << label << std::right << std::setw(12) << bytes
+           << std::setw(10) << average << '\n';
+    };
+
+    ss << std::left << std::setw(16) << "component" << std::right << std::setw(12)
+       << "bytes" << std::setw(10) << "avg" << '\n';
+    row("object", totals.object);
+    row("name", totals.name);
+    row("stats", totals.stats);
+    row("inventory", totals.inventory);
+    row("gear", totals.gear);
+    row("weapon table", totals.weaponTable);
+    row("abilities", totals.abilities);
+    row("status effects", totals.statusEffects);
+    row("total", totals.total());
+
+    if (characterCount > 0) {
+        ss << "largest: " << largestName << " (" << largest << " bytes)\n";
+    }
+    if (totals.opaqueAbilities > 0) {
+        ss << "abilities with opaque callables (captures not counted): "
+           << totals.opaqueAbilities << '\n';
+    }
+
+    return ss.str();
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+class Character;
+
+// estimated bytes held by one character, by component. object is
+// sizeof(Character); every other field counts heap memory only (tree nodes,
+// string buffers, vector storage), so the parts add up without overlap.
+struct CharacterMemoryUsage {
+    size_t object{};
+    size_t name{};
+    size_t stats{};
+    size_t inventory{};
+    size_t gear{};
+    size_t weaponTable{};
+    size_t abilities{};
+    size_t statusEffects{};
+
+    // abilities whose std::function holds something other than a plain
+    // function pointer. whatever that callable captures beyond std::function's
+    // small buffer lives on the heap and is not visible to these estimates.
+    int opaqueAbilities{};
+
+    size_t total() const;
+    CharacterMemoryUsage& operator+=(const CharacterMemoryUsage& other);
+};
+
+struct PartyMemoryUsage {
+    size_t object{};
+    size_t name{};
+    // member map nodes and their key strings, excluding the characters
+    size_t memberNodes{};
+    int memberCount{};
+    CharacterMemoryUsage members{};
+
+    size_t total() const;
+};
+
+// totals over a roster, printable as a table with report()
+struct RosterMemorySummary {
+    int characterCount{};
+    CharacterMemoryUsage totals{};
+    size_t largest{};
+    std::string largestName{};
+
+    static RosterMemorySummary summarize(const std::vector<Character>& roster);
+    std::string report() const;
+};
+
+// the estimates assume libstdc++ layouts: a red-black tree node is four
+// pointer-sized words plus the value, strings keep short values inline
+namespace memory {
+
+constexpr size_t MAP_NODE_OVERHEAD = 4 * sizeof(void*);
+
+inline size_t stringHeap(const std::string& value) {
+    static const size_t inlineCapacity = std::string().capacity();
+    return value.capacity() > inlineCapacity ? value.capacity() + 1 : 0;
+}
+
+template <typename T>
+size_t vectorHeap(const std::vector<T>& values) {
+    return values.capacity() * sizeof(T);
+}
+
+// node storage only; callers add heap owned by keys and values
+template <typename K, typename V>
+size_t mapNodes(const std::map<K, V>& values) {
+    return values.size() * (MAP_NODE_OVERHEAD + sizeof(typename std::map<K, V>::value_type));
+}
+
+}  // namespace memory
@@ -0,0 +1,60 @@
+#include "MutationJournal.h"
+
+#include "character.h"
+
+void MutationJournal::recordValue(Character* character, JournalField field,
+                                  int oldValue) {
+    JournalEntry entry{};
+    entry.character = character;
+    entry.field = field;
+    entry.existed = true;
+    entry.oldValue = oldValue;
+    entries.push_back(entry);
+}
+
+void MutationJournal::recordKey(Character* character, JournalField field,
+                                const std::string& key, bool existed, int oldValue) {
+    JournalEntry entry{};
+    entry.character = character;
+    entry.field = field;
+    entry.existed = existed;
+    entry.oldValue = oldValue;
+    entry.key = key;
+    entries.push_back(entry);
+}
+
+void MutationJournal::recordItem(Character* character, JournalField field, ItemId item,
+                                 bool existed, int oldValue) {
+    JournalEntry entry{};
+    entry.character = character;
+    entry.field = field;
+    entry.existed = existed;
+    entry.oldValue = oldValue;
+    entry.item = item;
+    entries.push_back(entry);
+}
+
+void MutationJournal::recordGear(Character* character, const std::string& slot,
+                                 bool existed, ItemId oldItem) {
+    JournalEntry entry{};
+    entry.character = character;
+    entry.field = JournalField::Gear;
+    entry.existed = existed;
+    entry.item = oldItem;
+    entry.key = slot;
+    entries.push_back(entry);
+}
+
+size_t MutationJournal::mark() const { return entries.size(); }
+
+void MutationJournal::rollback(size_t mark) {
+    while (entries.size() > mark) {
+        const JournalEntry& entry = entries.back();
+        entry.character->revert(entry);
+        entries.pop_back();
+    }
+}
+
+void MutationJournal::clear() { entries.clear(); }
+
+size_t MutationJournal::size() const { return entries.size(); }
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "ItemCatalog.h"
+
+class Character;
+
+enum class JournalField {
+    Health,
+    MaxHealth,
+    Experience,
+    Level,
+    Stat,
+    Inventory,
+    Gear,
+    WeaponDamage,
+    StatusEffect,
+    CriticalRate,
+    CriticalMultiplier,
+    Turn
+};
+
+// previous value of one field of one character. keyed fields (stats, gear)
+// use key; inventory, weapon damage and status effects store their item or
+// effect id in item. existed is false when the mutation created the entry.
+struct JournalEntry {
+    Character* character{};
+    JournalField field{};
+    bool existed{};
+    int oldValue{};
+    ItemId item{};
+    std::string key{};
+};
+
+// undo log shared by every character attached to it. mutating methods on an
+// attached character push the value they overwrite, so any number of moves can
+// be taken back by rolling back to a mark. learnAbility and setName are not
+// journaled.
+class MutationJournal {
+private:
+    std::vector<JournalEntry> entries{};
+
+public:
+    void recordValue(Character* character, JournalField field, int oldValue);
+    void recordKey(Character* character, JournalField field, const std::string& key,
+                   bool existed, int oldValue);
+    void recordItem(Character* character, JournalField field, ItemId item,
+                    bool existed, int oldValue);
+    void recordGear(Character* character, const std::string& slot, bool existed,
+                    ItemId oldItem);
+
+    // position to roll back to later
+    size_t mark() const;
+    // undoes every mutation recorded after mark, newest first
+    void rollback(size_t mark);
+    // forgets all entries, keeping the current state
+    void clear();
+    size_t size() const;
+};
+
+// the journal a character records into. copies start detached so a scratch
+// copy never writes into the journal of the character it was copied from.
+class JournalLink {
+private:
+    MutationJournal* journal{};
+
+public:
+    JournalLink() {}
+    JournalLink(const JournalLink&) {}
+    JournalLink& operator=(const JournalLink&) { return *this; }
+
+    void attach(MutationJournal* value) { journal = value; }
+    MutationJournal* get() const { return journal; }
+};
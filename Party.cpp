@@ -1,9 +1,26 @@
 #include "Party.h"
 
-Party::Party(std::string name) : partyName{name} {}
+#include <stdexcept>
+
+#include "BinaryCodec.h"
+#include "StateHash.h"
+#include "StringTable.h"
+
+namespace {
+const std::uint32_t PARTY_MAGIC = 0x59545250;  // "PRTY"
+// version 2 follows each member record with its scripted abilities
+const std::uint32_t PARTY_VERSION = 2;
+}  // namespace
+
+Party::Party(std::string name) : partyName{name} { stateHash = computeStateHash(); }
+
+const std::string& Party::getName() const { return partyName; }
 
 void Party::addMember(Character c) {
-    partyMembers.insert({ c.getName(), c });
+    auto inserted = partyMembers.insert({ c.getName(), std::move(c) });
+    if (inserted.second) {
+        stateHash ^= memberKey(inserted.first->first, inserted.first->second);
+    }
 }
 int Party::getMemberCount() {
     return static_cast<int>(partyMembers.size());
@@ -14,5 +31,140 @@ bool Party::hasMember(std::string memberName) {
 }
 
 void Party::removeMember(std::string memberName) {
-    partyMembers.erase(memberName);
+    auto it = partyMembers.find(memberName);
+    if (it == partyMembers.end()) {
+        return;
+    }
+
+    stateHash ^= memberKey(it->first, it->second);
+    partyMembers.erase(it);
+}
+
+bool Party::updateMember(const std::string& memberName,
+                         const std::function<void(Character&)>& update) {
+    auto it = partyMembers.find(memberName);
+    if (it == partyMembers.end()) {
+        return false;
+    }
+
+    stateHash ^= memberKey(it->first, it->second);
+    try {
+        update(it->second);
+    } catch (...) {
+        // a partial update still changed the member
+        stateHash ^= memberKey(it->first, it->second);
+        throw;
+    }
+    stateHash ^= memberKey(it->first, it->second);
+    return true;
+}
+
+void Party::forEachMember(const std::function<void(const Character&)>& visit) const {
+    for (const auto& pair : partyMembers) {
+        visit(pair.second);
+    }
+}
+
+std::uint64_t Party::memberKey(const std::string& memberName, const Character& member) {
+    return statehash::key(statehash::Tag::Member, statehash::ofString(memberName),
+                          static_cast<std::int64_t>(member.getStateHash()));
+}
+
+std::uint64_t Party::getStateHash() const { return stateHash; }
+
+std::uint64_t Party::computeStateHash() const {
+    std::uint64_t hash = statehash::key(statehash::Tag::Name, statehash::ofString(partyName), 0);
+    for (const auto& pair : partyMembers) {
+        hash ^= memberKey(pair.first, pair.second);
+    }
+
+    return hash;
+}
+
+PartyMemoryUsage Party::getMemoryUsage() const {
+    PartyMemoryUsage usage;
+    usage.object = sizeof(Party);
+    usage.name = memory::stringHeap(partyName);
+
+    // each node embeds a Character, which members.object already counts
+    usage.memberNodes =
+        partyMembers.size() * (memory::MAP_NODE_OVERHEAD + sizeof(std::string));
+    for (const auto& pair : partyMembers) {
+        usage.memberNodes += memory::stringHeap(pair.first);
+        usage.members += pair.second.getMemoryUsage();
+        usage.memberCount++;
+    }
+
+    return usage;
+}
+
+std::string Party::serialize() const {
+    // records are encoded first so the table holds exactly the names they use
+    StringTableWriter strings;
+    std::string records;
+    for (const auto& pair : partyMembers) {
+        const Character& member = pair.second;
+        member.writeRecord(records, strings);
+
+        // scripted abilities are saved as source; native functions cannot be
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> scripts;
+        for (const auto& ability : member.getAbilityNames()) {
+            if (auto program = member.getAbilityProgram(ability)) {
+                scripts.push_back({strings.intern(ability), strings.intern(program->getSource())});
+            }
+        }
+
+        binary::putVarUint(records, scripts.size());
+        for (const auto& script : scripts) {
+            binary::putVarUint(records, script.first);
+            binary::putVarUint(records, script.second);
+        }
+    }
+
+    std::string out;
+    binary::putU32(out, PARTY_MAGIC);
+    binary::putU32(out, PARTY_VERSION);
+    binary::putString(out, partyName);
+    strings.write(out);
+    binary::putVarUint(out, partyMembers.size());
+    out += records;
+
+    return out;
+}
+
+Party Party::deserialize(const std::string& data) {
+    size_t pos = 0;
+    if (binary::getU32(data, pos) != PARTY_MAGIC) {
+        throw std::domain_error("not a party save");
+    }
+    std::uint32_t version = binary::getU32(data, pos);
+    if (version < 1 || version > PARTY_VERSION) {
+        throw std::domain_error("unsupported party save version");
+    }
+
+    Party party(binary::getString(data, pos));
+    StringTableReader strings = StringTableReader::read(data, pos);
+
+    std::uint64_t memberCount = binary::getVarUint(data, pos);
+    AbilityProgramCache programs;
+    for (std::uint64_t i = 0; i < memberCount; i++) {
+        Character member = Character::readRecord(data, pos, strings);
+
+        std::uint64_t scriptCount = version >= 2 ? binary::getVarUint(data, pos) : 0;
+        for (std::uint64_t j = 0; j < scriptCount; j++) {
+            const std::string& ability = strings.at(binary::getVarUint(data, pos));
+            std::uint64_t source = binary::getVarUint(data, pos);
+
+            // members sharing a script share one compiled program
+            auto it = programs.find(source);
+            if (it == programs.end()) {
+                it = programs.emplace(source, AbilityProgram::compile(strings.at(source))).first;
+            }
+            member.learnAbility(ability, it->second);
+        }
+
+        party.addMember(std::move(member));
+    }
+
+    return party;
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <map>
 #include "character.h"
@@ -8,11 +10,37 @@ class Party {
 private:
     std::string partyName {};
     std::map<std::string, Character> partyMembers {};
+    // party name key xor one key per member, each folding in that member's
+    // own state hash
+    std::uint64_t stateHash {};
+
+    static std::uint64_t memberKey(const std::string& memberName, const Character& member);
 
 public:
     Party(std::string name);
+    const std::string& getName() const;
     void addMember(Character c);
     int getMemberCount();
     bool hasMember(std::string memberName);
     void removeMember(std::string memberName);
+    // runs update on a member in place and refreshes its share of the party
+    // hash; false if there is no such member
+    bool updateMember(const std::string& memberName,
+                      const std::function<void(Character&)>& update);
+    // visits members in name order
+    void forEachMember(const std::function<void(const Character&)>& visit) const;
+
+    // binary save: a header, one string table holding every name used by any
+    // member, then one compact record per member (see Character::writeRecord)
+    // followed by the source of its scripted abilities. native function
+    // abilities are not saved.
+    std::string serialize() const;
+    static Party deserialize(const std::string& data);
+
+    // estimated footprint of the party and its members
+    PartyMemoryUsage getMemoryUsage() const;
+
+    // lockstep desync detection, see Character::getStateHash
+    std::uint64_t getStateHash() const;
+    std::uint64_t computeStateHash() const;
 };
\ No newline at end of file
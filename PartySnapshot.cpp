@@ -0,0 +1,118 @@
+#include "PartySnapshot.h"
+
+#include <algorithm>
+#include <thread>
+
+const MemberView* PartySnapshot::find(const std::string& name) const {
+    auto it = std::lower_bound(
+        members.begin(), members.end(), name,
+        [](const MemberView& member, const std::string& key) { return member.name < key; });
+
+    return it != members.end() && it->name == name ? &*it : nullptr;
+}
+
+PartyPublisher::ReadGuard::ReadGuard(const PartyPublisher* publisher, int slot,
+                                     const PartySnapshot* snapshot)
+    : publisher{publisher}, slot{slot}, snapshot{snapshot} {}
+
+PartyPublisher::ReadGuard::ReadGuard(ReadGuard&& other) noexcept
+    : publisher{other.publisher}, slot{other.slot}, snapshot{other.snapshot} {
+    other.slot = -1;
+    other.snapshot = nullptr;
+}
+
+PartyPublisher::ReadGuard::~ReadGuard() {
+    if (slot >= 0) {
+        publisher->slots[slot].epoch.store(0);
+        publisher->slots[slot].taken.store(false, std::memory_order_release);
+    }
+}
+
+const PartySnapshot* PartyPublisher::ReadGuard::get() const { return snapshot; }
+
+const PartySnapshot* PartyPublisher::ReadGuard::operator->() const { return snapshot; }
+
+const PartySnapshot& PartyPublisher::ReadGuard::operator*() const { return *snapshot; }
+
+PartyPublisher::~PartyPublisher() {
+    for (const auto& entry : retired) {
+        delete entry.snapshot;
+    }
+    delete current.load();
+}
+
+std::uint64_t PartyPublisher::publish(const Party& party) {
+    auto snapshot = new PartySnapshot();
+    snapshot->version = nextVersion++;
+    snapshot->partyName = party.getName();
+    snapshot->stateHash = party.getStateHash();
+
+    // forEachMember visits in name order, so members come out sorted
+    party.forEachMember([snapshot](const Character& member) {
+        snapshot->members.push_back({member.getName(), member.getHealth(),
+                                     member.getMaxHealth(), member.getLevel(),
+                                     member.getExperience(), member.isDead(),
+                                     member.getStateHash()});
+    });
+
+    const PartySnapshot* old = current.exchange(snapshot);
+    if (old != nullptr) {
+        // any reader that can still see old announced an epoch no later than
+        // this one, because the epoch only moves after the swap
+        retired.push_back({old, epoch.fetch_add(1)});
+    }
+
+    reclaim();
+    return snapshot->version;
+}
+
+void PartyPublisher::reclaim() {
+    if (retired.empty()) {
+        return;
+    }
+
+    std::uint64_t oldest = UINT64_MAX;
+    for (const auto& slot : slots) {
+        std::uint64_t announced = slot.epoch.load();
+        if (announced != 0) {
+            oldest = std::min(oldest, announced);
+        }
+    }
+
+    auto kept = std::remove_if(retired.begin(), retired.end(), [oldest](const Retired& entry) {
+        if (entry.epoch < oldest) {
+            delete entry.snapshot;
+            return true;
+        }
+        return false;
+    });
+    retired.erase(kept, retired.end());
+}
+
+PartyPublisher::ReadGuard PartyPublisher::read() const {
+    // claim a free slot. readers only ever wait for each other, and only when
+    // more than MAX_READERS are reading at once
+    int slot = 0;
+    while (true) {
+        bool expected = false;
+        if (!slots[slot].taken.load(std::memory_order_relaxed) &&
+            slots[slot].taken.compare_exchange_weak(expected, true,
+                                                    std::memory_order_acquire)) {
+            break;
+        }
+
+        slot++;
+        if (slot == MAX_READERS) {
+            slot = 0;
+            std::this_thread::yield();
+        }
+    }
+
+    // announce before loading the pointer so the writer cannot free what we load
+    slots[slot].epoch.store(epoch.load());
+    const PartySnapshot* snapshot = current.load();
+
+    return ReadGuard(this, slot, snapshot);
+}
+
+size_t PartyPublisher::getRetiredCount() const { return retired.size(); }
@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Party.h"
+
+// the fields other services poll, copied out of one member
+struct MemberView {
+    std::string name{};
+    int health{};
+    int maxHealth{};
+    int level{};
+    int experience{};
+    bool dead{};
+    std::uint64_t stateHash{};
+};
+
+// immutable copy of a party as of one publish. members are sorted by name.
+struct PartySnapshot {
+    std::uint64_t version{};
+    std::string partyName{};
+    std::uint64_t stateHash{};
+    std::vector<MemberView> members{};
+
+    // binary search by name; nullptr if absent
+    const MemberView* find(const std::string& name) const;
+};
+
+// read-copy-update publication of party state. one writer thread (the
+// simulation) calls publish at turn boundaries; any number of reader threads
+// call read and get the latest snapshot without taking a lock or waiting on
+// the writer, and the writer never waits on readers.
+//
+// reclamation is epoch based. a reader announces the current epoch in one of
+// MAX_READERS slots before loading the snapshot pointer and clears it when its
+// guard is destroyed. publish swaps the pointer, retires the old snapshot with
+// the epoch it was replaced in and frees every retired snapshot older than
+// the oldest announced epoch. a reader that stalls only delays freeing.
+class PartyPublisher {
+public:
+    static constexpr int MAX_READERS = 64;
+
+    class ReadGuard {
+    private:
+        const PartyPublisher* publisher{};
+        int slot{-1};
+        const PartySnapshot* snapshot{};
+
+        friend class PartyPublisher;
+        ReadGuard(const PartyPublisher* publisher, int slot, const PartySnapshot* snapshot);
+
+    public:
+        ReadGuard(ReadGuard&& other) noexcept;
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ReadGuard& operator=(ReadGuard&&) = delete;
+        ~ReadGuard();
+
+        // nullptr before the first publish
+        const PartySnapshot* get() const;
+        const PartySnapshot* operator->() const;
+        const PartySnapshot& operator*() const;
+    };
+
+private:
+    // one cache line per slot so readers do not share lines
+    struct alignas(64) ReaderSlot {
+        std::atomic<bool> taken{false};
+        std::atomic<std::uint64_t> epoch{0};  // 0 = not reading
+    };
+
+    struct Retired {
+        const PartySnapshot* snapshot{};
+        std::uint64_t epoch{};
+    };
+
+    std::atomic<const PartySnapshot*> current{nullptr};
+    std::atomic<std::uint64_t> epoch{1};
+    mutable ReaderSlot slots[MAX_READERS]{};
+
+    // writer only
+    std::uint64_t nextVersion{1};
+    std::vector<Retired> retired{};
+
+    void reclaim();
+
+public:
+    PartyPublisher() {}
+    // readers must be finished before the publisher is destroyed
+    ~PartyPublisher();
+
+    PartyPublisher(const PartyPublisher&) = delete;
+    PartyPublisher& operator=(const PartyPublisher&) = delete;
+
+    // writer: copies the party's hot fields into a new snapshot and makes it
+    // the one readers see; returns its version
+    std::uint64_t publish(const Party& party);
+
+    // reader: pins the latest snapshot for the lifetime of the guard
+    ReadGuard read() const;
+
+    // writer: snapshots replaced but not yet freed because a reader may hold them
+    size_t getRetiredCount() const;
+};
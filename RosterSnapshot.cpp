@@ -0,0 +1,569 @@
+#include "RosterSnapshot.h"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include "BinaryCodec.h"
+
+namespace {
+using namespace binary;
+
+const std::uint32_t SNAPSHOT_MAGIC = 0x504E5352;  // "RSNP"
+const std::uint32_t SNAPSHOT_VERSION = 1;
+
+// the comparison is a template parameter so each loop body is branch-free
+template <typename Compare>
+void applyFilter(std::uint8_t* selected, const int* values, int count, int value,
+                 Compare compare) {
+    for (int i = 0; i < count; i++) {
+        selected[i] &= static_cast<std::uint8_t>(compare(values[i], value));
+    }
+}
+
+// row-major values collected while parsing, converted to columns at the end
+class ColumnBuilder {
+private:
+    int rowCount{};
+    std::map<std::string, std::vector<int>> values{};
+    std::map<std::string, std::vector<std::string>> dictionaries{};
+
+public:
+    void nextRow() { rowCount++; }
+
+    void set(const std::string& column, int value) {
+        std::vector<int>& columnValues = values[column];
+        columnValues.resize(rowCount, 0);
+        columnValues[rowCount - 1] = value;
+    }
+
+    void setGear(const std::string& slot, const std::string& item) {
+        std::vector<std::string>& dictionary = dictionaries[slot];
+        auto it = std::find(dictionary.begin(), dictionary.end(), item);
+        int code = static_cast<int>(it - dictionary.begin()) + 1;
+        if (it == dictionary.end()) {
+            dictionary.push_back(item);
+        }
+        set(RosterSnapshot::gear(slot), code);
+    }
+
+    int getRowCount() const { return rowCount; }
+
+    std::map<std::string, CompressedColumn> buildColumns() {
+        std::map<std::string, CompressedColumn> columns;
+        for (auto& pair : values) {
+            pair.second.resize(rowCount, 0);
+            columns[pair.first] = CompressedColumn(pair.second);
+        }
+        return columns;
+    }
+
+    std::map<std::string, std::vector<std::string>>& getDictionaries() {
+        return dictionaries;
+    }
+};
+}  // namespace
+
+// compressed column
+CompressedColumn::CompressedColumn(const std::vector<int>& values)
+    : rowCount{static_cast<int>(values.size())} {
+    for (size_t start = 0; start < values.size(); start += BLOCK_SIZE) {
+        size_t end = std::min(values.size(), start + BLOCK_SIZE);
+
+        auto range = std::minmax_element(values.begin() + start, values.begin() + end);
+        std::uint64_t spread = static_cast<std::uint64_t>(
+            static_cast<std::int64_t>(*range.second) - *range.first);
+
+        std::uint8_t bitWidth = 0;
+        while (bitWidth < 32 && (spread >> bitWidth) != 0) {
+            bitWidth++;
+        }
+
+        Block block{*range.first, bitWidth, static_cast<std::uint32_t>(words.size())};
+        blocks.push_back(block);
+
+        size_t bits = (end - start) * bitWidth;
+        words.resize(words.size() + (bits + 63) / 64, 0);
+
+        for (size_t i = start; i < end && bitWidth > 0; i++) {
+            std::uint64_t offset = static_cast<std::uint64_t>(
+                static_cast<std::int64_t>(values[i]) - block.base);
+            size_t bit = (i - start) * bitWidth;
+            size_t word = block.wordOffset + bit / 64;
+            size_t shift = bit % 64;
+
+            words[word] |= offset << shift;
+            if (shift + bitWidth > 64) {
+                words[word + 1] |= offset >> (64 - shift);
+            }
+        }
+    }
+}
+
+int CompressedColumn::getRowCount() const { return rowCount; }
+
+int CompressedColumn::getBlockCount() const { return static_cast<int>(blocks.size()); }
+
+int CompressedColumn::decodeBlock(int block, int* out) const {
+    const Block& header = blocks[block];
+    int count = std::min(BLOCK_SIZE, rowCount - block * BLOCK_SIZE);
+
+    if (header.bitWidth == 0) {
+        std::fill(out, out + count, header.base);
+        return count;
+    }
+
+    std::uint64_t mask = (std::uint64_t{1} << header.bitWidth) - 1;
+    const std::uint64_t* packed = words.data() + header.wordOffset;
+
+    for (int i = 0; i < count; i++) {
+        size_t bit = static_cast<size_t>(i) * header.bitWidth;
+        size_t word = bit / 64;
+        size_t shift = bit % 64;
+
+        std::uint64_t offset = packed[word] >> shift;
+        if (shift + header.bitWidth > 64) {
+            offset |= packed[word + 1] << (64 - shift);
+        }
+
+        out[i] = static_cast<int>(header.base + static_cast<std::int64_t>(offset & mask));
+    }
+
+    return count;
+}
+
+size_t CompressedColumn::getByteSize() const {
+    return blocks.size() * sizeof(Block) + words.size() * sizeof(std::uint64_t);
+}
+
+void CompressedColumn::write(std::string& out) const {
+    putU32(out, static_cast<std::uint32_t>(rowCount));
+    putU32(out, static_cast<std::uint32_t>(blocks.size()));
+    for (const auto& block : blocks) {
+        putU32(out, static_cast<std::uint32_t>(block.base));
+        putU32(out, block.bitWidth);
+        putU32(out, block.wordOffset);
+    }
+
+    putU32(out, static_cast<std::uint32_t>(words.size()));
+    for (std::uint64_t word : words) {
+        putU64(out, word);
+    }
+}
+
+CompressedColumn CompressedColumn::read(const std::string& data, size_t& pos) {
+    CompressedColumn column;
+    column.rowCount = static_cast<int>(getU32(data, pos));
+
+    std::uint32_t blockCount = getU32(data, pos);
+    for (std::uint32_t i = 0; i < blockCount; i++) {
+        Block block{};
+        block.base = static_cast<std::int32_t>(getU32(data, pos));
+        block.bitWidth = static_cast<std::uint8_t>(getU32(data, pos));
+        block.wordOffset = getU32(data, pos);
+        column.blocks.push_back(block);
+    }
+
+    std::uint32_t wordCount = getU32(data, pos);
+    for (std::uint32_t i = 0; i < wordCount; i++) {
+        column.words.push_back(getU64(data, pos));
+    }
+
+    // reject headers that would make decodeBlock read out of bounds
+    size_t expectedBlocks = (static_cast<size_t>(column.rowCount) + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    if (column.blocks.size() != expectedBlocks) {
+        throw std::domain_error("invalid roster snapshot column");
+    }
+    for (size_t i = 0; i < column.blocks.size(); i++) {
+        const Block& block = column.blocks[i];
+        size_t rows = std::min<size_t>(BLOCK_SIZE, column.rowCount - i * BLOCK_SIZE);
+        size_t wordsNeeded = (rows * block.bitWidth + 63) / 64;
+        if (block.bitWidth > 32 || block.wordOffset + wordsNeeded > column.words.size()) {
+            throw std::domain_error("invalid roster snapshot column");
+        }
+    }
+
+    return column;
+}
+
+// snapshot
+RosterSnapshot RosterSnapshot::fromCharacters(const std::vector<Character>& roster) {
+    std::vector<std::string> serialized;
+    serialized.reserve(roster.size());
+
+    for (const auto& character : roster) {
+        serialized.push_back(character.serialize());
+    }
+
+    return fromSerialized(serialized);
+}
+
+RosterSnapshot RosterSnapshot::fromSerialized(const std::vector<std::string>& roster) {
+    ColumnBuilder builder;
+
+    for (const auto& data : roster) {
+        std::stringstream ss(data);
+        builder.nextRow();
+
+        std::string name;
+        std::getline(ss, name);
+
+        int value;
+        ss >> value;
+        builder.set(level(), value);
+        ss >> value;
+        builder.set(experience(), value);
+
+        size_t statsMapSize;
+        ss >> statsMapSize;
+        ss.ignore();
+
+        for (size_t i = 0; i < statsMapSize; i++) {
+            std::string key;
+            std::getline(ss, key);
+            ss >> value;
+            ss.ignore();
+
+            builder.set(stat(key), value);
+        }
+
+        size_t inventoryMapSize;
+        ss >> inventoryMapSize;
+        ss.ignore();
+
+        for (size_t i = 0; i < inventoryMapSize; i++) {
+            std::string key;
+            std::getline(ss, key);
+            ss >> value;
+            ss.ignore();
+
+            builder.set(item(key), value);
+        }
+
+        size_t gearMapSize;
+        ss >> gearMapSize;
+        ss.ignore();
+
+        for (size_t i = 0; i < gearMapSize; i++) {
+            std::string slot;
+            std::string equipped;
+            std::getline(ss, slot);
+            std::getline(ss, equipped);
+
+            builder.setGear(slot, equipped);
+        }
+    }
+
+    RosterSnapshot snapshot;
+    snapshot.rowCount = builder.getRowCount();
+    snapshot.columns = builder.buildColumns();
+    snapshot.gearDictionaries = builder.getDictionaries();
+
+    return snapshot;
+}
+
+std::string RosterSnapshot::level() { return "level"; }
+
+std::string RosterSnapshot::experience() { return "experience"; }
+
+std::string RosterSnapshot::stat(const std::string& name) { return "stat:" + name; }
+
+std::string RosterSnapshot::item(const std::string& name) { return "item:" + name; }
+
+std::string RosterSnapshot::gear(const std::string& slot) { return "gear:" + slot; }
+
+int RosterSnapshot::getRowCount() const { return rowCount; }
+
+std::vector<std::string> RosterSnapshot::getColumnNames() const {
+    std::vector<std::string> names;
+    for (const auto& pair : columns) {
+        names.push_back(pair.first);
+    }
+    return names;
+}
+
+bool RosterSnapshot::hasColumn(const std::string& name) const {
+    return columns.count(name) != 0;
+}
+
+const CompressedColumn* RosterSnapshot::findColumn(const std::string& name) const {
+    auto it = columns.find(name);
+    return it != columns.end() ? &it->second : nullptr;
+}
+
+int RosterSnapshot::gearCode(const std::string& slot, const std::string& item) const {
+    auto dictionary = gearDictionaries.find(slot);
+    if (dictionary == gearDictionaries.end()) {
+        return -1;
+    }
+
+    const std::vector<std::string>& items = dictionary->second;
+    auto it = std::find(items.begin(), items.end(), item);
+    return it != items.end() ? static_cast<int>(it - items.begin()) + 1 : -1;
+}
+
+size_t RosterSnapshot::getByteSize() const {
+    size_t total = 0;
+    for (const auto& pair : columns) {
+        total += pair.first.size() + pair.second.getByteSize();
+    }
+    return total;
+}
+
+std::string RosterSnapshot::serialize() const {
+    std::string out;
+    putU32(out, SNAPSHOT_MAGIC);
+    putU32(out, SNAPSHOT_VERSION);
+    putU32(out, static_cast<std::uint32_t>(rowCount));
+
+    putU32(out, static_cast<std::uint32_t>(columns.size()));
+    for (const auto& pair : columns) {
+        putString(out, pair.first);
+        pair.second.write(out);
+    }
+
+    putU32(out, static_cast<std::uint32_t>(gearDictionaries.size()));
+    for (const auto& pair : gearDictionaries) {
+        putString(out, pair.first);
+        putU32(out, static_cast<std::uint32_t>(pair.second.size()));
+        for (const auto& item : pair.second) {
+            putString(out, item);
+        }
+    }
+
+    return out;
+}
+
+RosterSnapshot RosterSnapshot::deserialize(const std::string& data) {
+    size_t pos = 0;
+    if (getU32(data, pos) != SNAPSHOT_MAGIC || getU32(data, pos) != SNAPSHOT_VERSION) {
+        throw std::domain_error("not a roster snapshot");
+    }
+
+    RosterSnapshot snapshot;
+    snapshot.rowCount = static_cast<int>(getU32(data, pos));
+
+    std::uint32_t columnCount = getU32(data, pos);
+    for (std::uint32_t i = 0; i < columnCount; i++) {
+        std::string name = getString(data, pos);
+        CompressedColumn column = CompressedColumn::read(data, pos);
+        if (column.getRowCount() != snapshot.rowCount) {
+            throw std::domain_error("roster snapshot column has wrong length");
+        }
+        snapshot.columns[name] = column;
+    }
+
+    std::uint32_t dictionaryCount = getU32(data, pos);
+    for (std::uint32_t i = 0; i < dictionaryCount; i++) {
+        std::string slot = getString(data, pos);
+        std::uint32_t itemCount = getU32(data, pos);
+        std::vector<std::string>& items = snapshot.gearDictionaries[slot];
+        for (std::uint32_t j = 0; j < itemCount; j++) {
+            items.push_back(getString(data, pos));
+        }
+    }
+
+    return snapshot;
+}
+
+// query
+RosterQuery::RosterQuery(const RosterSnapshot& snapshot) : snapshot{snapshot} {}
+
+RosterQuery& RosterQuery::where(const std::string& column, Comparison comparison,
+                                int value) {
+    filters.push_back({column, comparison, value});
+    return *this;
+}
+
+RosterQuery& RosterQuery::whereEquipped(const std::string& slot, const std::string& item) {
+    // items never equipped in this roster get code -1, which matches no row
+    return where(RosterSnapshot::gear(slot), Comparison::Equal,
+                 snapshot.gearCode(slot, item));
+}
+
+int RosterQuery::selectBlock(int block, std::uint8_t* selected, int* scratch) const {
+    int count = std::min(CompressedColumn::BLOCK_SIZE,
+                         snapshot.getRowCount() - block * CompressedColumn::BLOCK_SIZE);
+    std::fill(selected, selected + count, 1);
+
+    for (const auto& filter : filters) {
+        const CompressedColumn* column = snapshot.findColumn(filter.column);
+        if (column != nullptr) {
+            column->decodeBlock(block, scratch);
+        } else {
+            std::fill(scratch, scratch + count, 0);
+        }
+
+        switch (filter.comparison) {
+            case Comparison::Equal:
+                applyFilter(selected, scratch, count, filter.value,
+                            [](int a, int b) { return a == b; });
+                break;
+            case Comparison::NotEqual:
+                applyFilter(selected, scratch, count, filter.value,
+                            [](int a, int b) { return a != b; });
+                break;
+            case Comparison::Less:
+                applyFilter(selected, scratch, count, filter.value,
+                            [](int a, int b) { return a < b; });
+                break;
+            case Comparison::LessEqual:
+                applyFilter(selected, scratch, count, filter.value,
+                            [](int a, int b) { return a <= b; });
+                break;
+            case Comparison::Greater:
+                applyFilter(selected, scratch, count, filter.value,
+                            [](int a, int b) { return a > b; });
+                break;
+            case Comparison::GreaterEqual:
+                applyFilter(selected, scratch, count, filter.value,
+                            [](int a, int b) { return a >= b; });
+                break;
+        }
+    }
+
+    return count;
+}
+
+template <typename Visit>
+void RosterQuery::scan(const std::string& column, Visit visit) const {
+    std::vector<std::uint8_t> selected(CompressedColumn::BLOCK_SIZE);
+    std::vector<int> scratch(CompressedColumn::BLOCK_SIZE);
+    std::vector<int> values(CompressedColumn::BLOCK_SIZE, 0);
+
+    const CompressedColumn* valueColumn =
+        column.empty() ? nullptr : snapshot.findColumn(column);
+
+    int blockCount = (snapshot.getRowCount() + CompressedColumn::BLOCK_SIZE - 1) /
+                     CompressedColumn::BLOCK_SIZE;
+
+    for (int block = 0; block < blockCount; block++) {
+        int count = selectBlock(block, selected.data(), scratch.data());
+        if (valueColumn != nullptr) {
+            valueColumn->decodeBlock(block, values.data());
+        }
+        visit(values.data(), selected.data(), count);
+    }
+}
+
+int RosterQuery::count() const {
+    long long total = 0;
+    scan("", [&total](const int*, const std::uint8_t* selected, int count) {
+        for (int i = 0; i < count; i++) {
+            total += selected[i];
+        }
+    });
+    return static_cast<int>(total);
+}
+
+long long RosterQuery::sum(const std::string& column) const {
+    long long total = 0;
+    scan(column, [&total](const int* values, const std::uint8_t* selected, int count) {
+        for (int i = 0; i < count; i++) {
+            total += static_cast<long long>(values[i]) * selected[i];
+        }
+    });
+    return total;
+}
+
+double RosterQuery::average(const std::string& column) const {
+    long long total = 0;
+    long long rows = 0;
+    scan(column, [&](const int* values, const std::uint8_t* selected, int count) {
+        for (int i = 0; i < count; i++) {
+            total += static_cast<long long>(values[i]) * selected[i];
+            rows += selected[i];
+        }
+    });
+    return rows == 0 ? 0.0 : static_cast<double>(total) / rows;
+}
+
+int RosterQuery::min(const std::string& column) const {
+    int result = std::numeric_limits<int>::max();
+    bool any = false;
+    scan(column, [&](const int* values, const std::uint8_t* selected, int count) {
+        for (int i = 0; i < count; i++) {
+            // unselected rows are replaced by the identity of min
+            int candidate = selected[i] ? values[i] : std::numeric_limits<int>::max();
+            result = std::min(result, candidate);
+            any = any || selected[i];
+        }
+    });
+
+    if (!any) {
+        throw std::domain_error("no rows match query");
+    }
+    return result;
+}
+
+int RosterQuery::max(const std::string& column) const {
+    int result = std::numeric_limits<int>::min();
+    bool any = false;
+    scan(column, [&](const int* values, const std::uint8_t* selected, int count) {
+        for (int i = 0; i < count; i++) {
+            int candidate = selected[i] ? values[i] : std::numeric_limits<int>::min();
+            result = std::max(result, candidate);
+            any = any || selected[i];
+        }
+    });
+
+    if (!any) {
+        throw std::domain_error("no rows match query");
+    }
+    return result;
+}
+
+std::map<int, std::pair<long long, long long>> RosterQuery::groupTotals(
+    const std::string& groupColumn, const std::string& column) const {
+    std::map<int, std::pair<long long, long long>> totals;
+
+    const CompressedColumn* keyColumn = snapshot.findColumn(groupColumn);
+    std::vector<int> keys(CompressedColumn::BLOCK_SIZE, 0);
+    int block = 0;
+
+    // scan visits blocks in order, so the key block can be decoded alongside
+    scan(column, [&](const int* values, const std::uint8_t* selected, int count) {
+        if (keyColumn != nullptr) {
+            keyColumn->decodeBlock(block, keys.data());
+        }
+        block++;
+
+        for (int i = 0; i < count; i++) {
+            if (selected[i]) {
+                auto& total = totals[keys[i]];
+                total.first += values[i];
+                total.second++;
+            }
+        }
+    });
+
+    return totals;
+}
+
+std::map<int, long long> RosterQuery::countBy(const std::string& groupColumn) const {
+    std::map<int, long long> counts;
+    for (const auto& pair : groupTotals(groupColumn, "")) {
+        counts[pair.first] = pair.second.second;
+    }
+    return counts;
+}
+
+std::map<int, long long> RosterQuery::sumBy(const std::string& groupColumn,
+                                            const std::string& column) const {
+    std::map<int, long long> sums;
+    for (const auto& pair : groupTotals(groupColumn, column)) {
+        sums[pair.first] = pair.second.first;
+    }
+    return sums;
+}
+
+std::map<int, double> RosterQuery::averageBy(const std::string& groupColumn,
+                                             const std::string& column) const {
+    std::map<int, double> averages;
+    for (const auto& pair : groupTotals(groupColumn, column)) {
+        averages[pair.first] =
+            static_cast<double>(pair.second.first) / pair.second.second;
+    }
+    return averages;
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "character.h"
+
+// integer column stored in fixed-size blocks. every block is frame-of-reference
+// encoded (block minimum + bit-packed offsets), so decoding a block is a tight
+// loop and constant columns cost a few bytes per block.
+class CompressedColumn {
+public:
+    static constexpr int BLOCK_SIZE = 1024;
+
+private:
+    struct Block {
+        std::int32_t base{};
+        std::uint8_t bitWidth{};
+        std::uint32_t wordOffset{};
+    };
+
+    int rowCount{};
+    std::vector<Block> blocks{};
+    std::vector<std::uint64_t> words{};
+
+public:
+    CompressedColumn() {}
+    explicit CompressedColumn(const std::vector<int>& values);
+
+    int getRowCount() const;
+    int getBlockCount() const;
+
+    // decodes one block into out (BLOCK_SIZE entries) and returns its row count
+    int decodeBlock(int block, int* out) const;
+    size_t getByteSize() const;
+
+    void write(std::string& out) const;
+    static CompressedColumn read(const std::string& data, size_t& pos);
+};
+
+// read-only, column-oriented snapshot of a roster of characters. level,
+// experience, every stat and every item count are separate columns; gear
+// slots are dictionary-encoded (0 = empty slot).
+class RosterSnapshot {
+private:
+    int rowCount{};
+    std::map<std::string, CompressedColumn> columns{};
+    std::map<std::string, std::vector<std::string>> gearDictionaries{};
+
+public:
+    RosterSnapshot() {}
+
+    static RosterSnapshot fromCharacters(const std::vector<Character>& roster);
+    // builds columns straight from Character::serialize output without
+    // constructing any Character
+    static RosterSnapshot fromSerialized(const std::vector<std::string>& roster);
+
+    // column names
+    static std::string level();
+    static std::string experience();
+    static std::string stat(const std::string& name);
+    static std::string item(const std::string& name);
+    static std::string gear(const std::string& slot);
+
+    int getRowCount() const;
+    std::vector<std::string> getColumnNames() const;
+    bool hasColumn(const std::string& name) const;
+    // nullptr for columns no character in the roster has (all values 0)
+    const CompressedColumn* findColumn(const std::string& name) const;
+    // dictionary code of item in a gear column, or -1 if never equipped there
+    int gearCode(const std::string& slot, const std::string& item) const;
+    size_t getByteSize() const;
+
+    std::string serialize() const;
+    static RosterSnapshot deserialize(const std::string& data);
+};
+
+enum class Comparison { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual };
+
+// filters and aggregates over a snapshot. only the columns named by the
+// filters and the aggregate are decoded.
+class RosterQuery {
+private:
+    struct Filter {
+        std::string column{};
+        Comparison comparison{};
+        int value{};
+    };
+
+    const RosterSnapshot& snapshot;
+    std::vector<Filter> filters{};
+
+    // fills selected with 1/0 per row of block, returns the block's row count
+    int selectBlock(int block, std::uint8_t* selected, int* scratch) const;
+
+    // calls visit(values, selected, rowCount) for every block, with values
+    // decoded from column (zeros if the roster has no such column)
+    template <typename Visit>
+    void scan(const std::string& column, Visit visit) const;
+
+    // (sum, count) of column per distinct value of groupColumn
+    std::map<int, std::pair<long long, long long>> groupTotals(
+        const std::string& groupColumn, const std::string& column) const;
+
+public:
+    explicit RosterQuery(const RosterSnapshot& snapshot);
+
+    RosterQuery& where(const std::string& column, Comparison comparison, int value);
+    RosterQuery& whereEquipped(const std::string& slot, const std::string& item);
+
+    int count() const;
+    long long sum(const std::string& column) const;
+    double average(const std::string& column) const;
+    int min(const std::string& column) const;
+    int max(const std::string& column) const;
+
+    std::map<int, long long> countBy(const std::string& groupColumn) const;
+    std::map<int, long long> sumBy(const std::string& groupColumn,
+                                   const std::string& column) const;
+    std::map<int, double> averageBy(const std::string& groupColumn,
+                                    const std::string& column) const;
+};
@@ -0,0 +1,675 @@
+#include "SimulationServer.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+// frames are a 4-byte little-endian length followed by the payload
+const std::uint32_t MAX_FRAME_SIZE = 64 * 1024 * 1024;
+
+// requests one connection may have read but not yet answered. past this the
+// server stops reading from it until the client takes some results.
+const int MAX_PENDING_RESULTS = 4096;
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool readAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t received = ::recv(fd, data, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        data += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+bool writeFrame(int fd, const std::string& payload) {
+    std::string frame;
+    frame.reserve(payload.size() + 4);
+    std::uint32_t size = static_cast<std::uint32_t>(payload.size());
+    for (int i = 0; i < 4; i++) {
+        frame.push_back(static_cast<char>((size >> (i * 8)) & 0xFF));
+    }
+    frame += payload;
+
+    return writeAll(fd, frame.data(), frame.size());
+}
+
+bool readFrame(int fd, std::string& payload) {
+    unsigned char header[4];
+    if (!readAll(fd, reinterpret_cast<char*>(header), 4)) {
+        return false;
+    }
+
+    std::uint32_t size = header[0] | (header[1] << 8) | (header[2] << 16) |
+                         (static_cast<std::uint32_t>(header[3]) << 24);
+    if (size > MAX_FRAME_SIZE) {
+        return false;
+    }
+
+    payload.resize(size);
+    return size == 0 || readAll(fd, &payload[0], size);
+}
+
+sockaddr_un socketAddress(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::domain_error("socket path too long");
+    }
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    return address;
+}
+
+std::runtime_error systemError(const std::string& what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+Character& characterAt(std::vector<Character>& characters, int index) {
+    if (index < 0 || index >= static_cast<int>(characters.size())) {
+        throw std::domain_error("character index out of range");
+    }
+    return characters[index];
+}
+
+std::string restOfLine(std::istringstream& ss) {
+    std::string rest;
+    std::getline(ss >> std::ws, rest);
+    return rest;
+}
+}  // namespace
+
+// request
+SimulationRequest::SimulationRequest(std::uint64_t id) : id{id}, seed{id} {}
+
+void SimulationRequest::addCharacter(const Character& character, int health) {
+    CharacterSpec spec{};
+    spec.health = health;
+    spec.maxHealth = character.getMaxHealth();
+    spec.payload = character.serialize();
+    characters.push_back(spec);
+}
+
+void SimulationRequest::addArchetype(const std::string& archetype,
+                                     const std::string& name) {
+    CharacterSpec spec{};
+    spec.fromArchetype = true;
+    spec.archetype = archetype;
+    spec.name = name;
+    characters.push_back(spec);
+}
+
+void SimulationRequest::addAction(const std::string& action) {
+    if (action.find('\n') != std::string::npos) {
+        throw std::domain_error("actions cannot contain newlines");
+    }
+    script.push_back(action);
+}
+
+void SimulationRequest::setSeed(std::uint64_t seed) { this->seed = seed; }
+
+std::uint64_t SimulationRequest::getId() const { return id; }
+
+std::uint64_t SimulationRequest::getSeed() const { return seed; }
+
+int SimulationRequest::getCharacterCount() const {
+    return static_cast<int>(characters.size());
+}
+
+int SimulationRequest::getActionCount() const { return static_cast<int>(script.size()); }
+
+std::string SimulationRequest::encode() const {
+    std::stringstream ss;
+    ss << id << ' ' << seed << '\n';
+    ss << characters.size() << '\n';
+
+    for (const auto& spec : characters) {
+        if (spec.fromArchetype) {
+            ss << "archetype " << spec.archetype << ' ' << spec.name << '\n';
+        } else {
+            ss << "character " << spec.health << ' ' << spec.maxHealth << ' '
+               << spec.payload.size() << '\n';
+            ss << spec.payload;
+        }
+    }
+
+    ss << script.size() << '\n';
+    for (const auto& action : script) {
+        ss << action << '\n';
+    }
+
+    return ss.str();
+}
+
+SimulationRequest SimulationRequest::decode(const std::string& data) {
+    std::istringstream ss(data);
+    SimulationRequest request;
+
+    size_t characterCount;
+    if (!(ss >> request.id >> request.seed >> characterCount)) {
+        throw std::domain_error("malformed simulation request");
+    }
+
+    for (size_t i = 0; i < characterCount; i++) {
+        std::string kind;
+        ss >> kind;
+
+        CharacterSpec spec{};
+        if (kind == "archetype") {
+            spec.fromArchetype = true;
+            ss >> spec.archetype;
+            spec.name = restOfLine(ss);
+        } else if (kind == "character") {
+            size_t length;
+            ss >> spec.health >> spec.maxHealth >> length;
+            ss.ignore();
+
+            // the length comes off the wire, so check it before allocating
+            std::streamoff offset = ss.tellg();
+            if (!ss || offset < 0 || length > data.size() - static_cast<size_t>(offset)) {
+                throw std::domain_error("malformed simulation request");
+            }
+            spec.payload.resize(length);
+            ss.read(&spec.payload[0], static_cast<std::streamsize>(length));
+        } else {
+            throw std::domain_error("malformed simulation request");
+        }
+
+        if (!ss) {
+            throw std::domain_error("malformed simulation request");
+        }
+        request.characters.push_back(spec);
+    }
+
+    size_t actionCount;
+    if (!(ss >> actionCount)) {
+        throw std::domain_error("malformed simulation request");
+    }
+    ss.ignore();
+
+    for (size_t i = 0; i < actionCount; i++) {
+        std::string action;
+        std::getline(ss, action);
+        request.script.push_back(action);
+    }
+
+    return request;
+}
+
+// result
+std::string SimulationResult::encode() const {
+    std::stringstream ss;
+    ss << id << '\n';
+    ss << (ok ? "ok" : "error " + error) << '\n';
+    ss << characters.size() << '\n';
+
+    for (const auto& outcome : characters) {
+        ss << outcome.health << ' ' << outcome.maxHealth << ' ' << outcome.level << ' '
+           << outcome.dead << '\n';
+    }
+
+    return ss.str();
+}
+
+SimulationResult SimulationResult::decode(const std::string& data) {
+    std::istringstream ss(data);
+    SimulationResult result;
+
+    std::string status;
+    ss >> result.id >> status;
+    result.ok = status == "ok";
+    if (!result.ok) {
+        result.error = restOfLine(ss);
+    }
+
+    size_t count = 0;
+    ss >> count;
+    for (size_t i = 0; i < count && ss; i++) {
+        CharacterOutcome outcome;
+        ss >> outcome.health >> outcome.maxHealth >> outcome.level >> outcome.dead;
+        result.characters.push_back(outcome);
+    }
+
+    if (!ss) {
+        throw std::domain_error("malformed simulation result");
+    }
+
+    return result;
+}
+
+// server
+// each connection has a reader that decodes requests into jobs and a writer
+// that sends results back, so workers only ever queue a result and a client
+// that stops reading cannot hold up a worker.
+struct SimulationServer::Connection {
+    int fd{-1};
+    std::thread reader{};
+    std::thread writer{};
+    std::atomic<bool> finished{false};
+
+    std::mutex outputMutex{};
+    std::condition_variable resultReady{};
+    std::condition_variable resultSent{};
+    std::deque<std::string> output{};
+    int pending{};         // read but not yet written back
+    bool closing{};        // the reader has stopped
+    bool broken{};         // a write failed; results are dropped
+
+    explicit Connection(int fd) : fd{fd} {}
+    ~Connection() { ::close(fd); }
+};
+
+SimulationServer::SimulationServer(const std::string& socketPath, unsigned workers)
+    : socketPath{socketPath}, workerCount{workers} {
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    registerArchetype("Warrior", Character::createWarrior("Warrior"));
+    registerArchetype("Mage", Character::createMage("Mage"));
+    registerArchetype("Rogue", Character::createRogue("Rogue"));
+
+    registerAbility("Fireball", "damage target caster.Intelligence * 2");
+    registerAbility("Heal", "heal target caster.Intelligence");
+    registerAbility("Poison Strike",
+                    "damage target caster.Dexterity\n"
+                    "status target Poison 3");
+    registerAbility("Fire Breath", "damage target 30");
+}
+
+SimulationServer::~SimulationServer() { stop(); }
+
+void SimulationServer::registerArchetype(const std::string& name,
+                                         const Character& character) {
+    if (running) {
+        throw std::domain_error("cannot register archetypes while running");
+    }
+    archetypes.erase(name);
+    archetypes.insert({name, character});
+}
+
+void SimulationServer::registerAbility(const std::string& name,
+                                       std::function<bool(Character&, Character&)> ability) {
+    if (running) {
+        throw std::domain_error("cannot register abilities while running");
+    }
+    scriptedAbilities.erase(name);
+    abilities[name] = ability;
+}
+
+void SimulationServer::registerAbility(const std::string& name, const std::string& source) {
+    if (running) {
+        throw std::domain_error("cannot register abilities while running");
+    }
+    abilities.erase(name);
+    scriptedAbilities[name] = AbilityProgram::compile(source);
+}
+
+void SimulationServer::start() {
+    if (running) {
+        return;
+    }
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        throw systemError("socket");
+    }
+
+    sockaddr_un address = socketAddress(socketPath);
+    ::unlink(socketPath.c_str());
+
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        ::listen(listenFd, SOMAXCONN) < 0) {
+        std::runtime_error error = systemError("bind " + socketPath);
+        ::close(listenFd);
+        listenFd = -1;
+        throw error;
+    }
+
+    running = true;
+
+    for (unsigned i = 0; i < workerCount; i++) {
+        workers.emplace_back(&SimulationServer::workerLoop, this);
+    }
+    acceptThread = std::thread(&SimulationServer::acceptLoop, this);
+}
+
+void SimulationServer::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+
+    // wakes the blocked accept(). the descriptor is only closed once the
+    // accept thread has stopped reading it
+    ::shutdown(listenFd, SHUT_RDWR);
+    acceptThread.join();
+    ::close(listenFd);
+    listenFd = -1;
+
+    std::vector<std::shared_ptr<Connection>> open;
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        open.swap(connections);
+    }
+    for (auto& connection : open) {
+        ::shutdown(connection->fd, SHUT_RDWR);
+        {
+            // wakes a reader waiting for room
+            std::lock_guard<std::mutex> lock(connection->outputMutex);
+        }
+        connection->resultSent.notify_all();
+        connection->reader.join();
+        connection->writer.join();
+    }
+
+    jobsReady.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    ::unlink(socketPath.c_str());
+}
+
+bool SimulationServer::isRunning() const { return running; }
+
+std::uint64_t SimulationServer::getCompletedJobs() const { return completedJobs; }
+
+void SimulationServer::acceptLoop() {
+    while (running) {
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+
+        auto connection = std::make_shared<Connection>(fd);
+
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+
+        // reap connections whose client has gone away
+        for (auto it = connections.begin(); it != connections.end();) {
+            if ((*it)->finished) {
+                (*it)->reader.join();
+                (*it)->writer.join();
+                it = connections.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        connection->reader = std::thread(&SimulationServer::readLoop, this, connection);
+        connection->writer = std::thread(&SimulationServer::writeLoop, this, connection);
+        connections.push_back(connection);
+    }
+}
+
+void SimulationServer::readLoop(std::shared_ptr<Connection> connection) {
+    std::string payload;
+
+    while (running && readFrame(connection->fd, payload)) {
+        {
+            std::unique_lock<std::mutex> lock(connection->outputMutex);
+            connection->resultSent.wait(lock, [this, &connection]() {
+                return connection->pending < MAX_PENDING_RESULTS || connection->broken ||
+                       !running;
+            });
+            if (connection->broken || !running) {
+                break;
+            }
+            connection->pending++;
+        }
+
+        enqueue([this, connection, payload]() {
+            SimulationResult result;
+            try {
+                result = run(SimulationRequest::decode(payload));
+            } catch (const std::exception& e) {
+                result.ok = false;
+                result.error = e.what();
+            }
+
+            std::string encoded = result.encode();
+            completedJobs++;
+
+            {
+                std::lock_guard<std::mutex> lock(connection->outputMutex);
+                connection->output.push_back(std::move(encoded));
+            }
+            connection->resultReady.notify_one();
+        });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(connection->outputMutex);
+        connection->closing = true;
+    }
+    connection->resultReady.notify_one();
+}
+
+void SimulationServer::writeLoop(std::shared_ptr<Connection> connection) {
+    std::unique_lock<std::mutex> lock(connection->outputMutex);
+
+    // results for requests already read are still sent after the client
+    // stops sending
+    while (true) {
+        connection->resultReady.wait(lock, [&connection]() {
+            return !connection->output.empty() ||
+                   (connection->closing && connection->pending == 0);
+        });
+        if (connection->output.empty()) {
+            break;
+        }
+
+        std::string encoded = std::move(connection->output.front());
+        connection->output.pop_front();
+
+        if (!connection->broken) {
+            lock.unlock();
+            bool sent = writeFrame(connection->fd, encoded);
+            lock.lock();
+            connection->broken = !sent;
+        }
+
+        connection->pending--;
+        connection->resultSent.notify_one();
+    }
+
+    connection->finished = true;
+}
+
+void SimulationServer::enqueue(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        jobs.push_back(std::move(job));
+    }
+    jobsReady.notify_one();
+}
+
+void SimulationServer::workerLoop() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(jobsMutex);
+            jobsReady.wait(lock, [this]() { return !running || !jobs.empty(); });
+
+            // queued jobs still run after stop so nothing is silently dropped
+            if (jobs.empty()) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        job();
+    }
+}
+
+SimulationResult SimulationServer::run(const SimulationRequest& request) const {
+    SimulationResult result;
+    result.id = request.id;
+
+    try {
+        // Character::attack rolls with the global rand(), which is shared by
+        // every worker; each request rolls from its own generator instead
+        std::mt19937_64 rng(request.seed);
+        std::uniform_int_distribution<int> d100(1, 100);
+
+        std::vector<Character> characters;
+        characters.reserve(request.characters.size());
+
+        for (const auto& spec : request.characters) {
+            if (spec.fromArchetype) {
+                auto archetype = archetypes.find(spec.archetype);
+                if (archetype == archetypes.end()) {
+                    throw std::domain_error("unknown archetype " + spec.archetype);
+                }
+                characters.push_back(archetype->second);
+                characters.back().setName(spec.name);
+            } else {
+                characters.push_back(Character::deserialize(spec.payload));
+                characters.back().setHealth(spec.maxHealth);
+                characters.back().heal(spec.health);
+            }
+        }
+
+        for (const auto& line : request.script) {
+            std::istringstream ss(line);
+            std::string action;
+            ss >> action;
+
+            if (action == "attack") {
+                int attacker, target;
+                ss >> attacker >> target;
+                Character& user = characterAt(characters, attacker);
+                user.resolveAttack(characterAt(characters, target),
+                                   d100(rng) > user.getDerivedStats().critThreshold);
+            } else if (action == "ability") {
+                int caster, target;
+                ss >> caster >> target;
+                std::string ability = restOfLine(ss);
+
+                Character& user = characterAt(characters, caster);
+                Character& victim = characterAt(characters, target);
+
+                // abilities the character knows win over the server library,
+                // even when they decline to act
+                if (user.hasAbility(ability)) {
+                    user.useAbility(ability, victim);
+                } else {
+                    auto scripted = scriptedAbilities.find(ability);
+                    auto library = abilities.find(ability);
+                    if (scripted != scriptedAbilities.end()) {
+                        scripted->second->run(user, victim);
+                    } else if (library != abilities.end()) {
+                        library->second(user, victim);
+                    } else {
+                        throw std::domain_error("unknown ability " + ability);
+                    }
+                }
+            } else if (action == "damage") {
+                int target, amount;
+                ss >> target >> amount;
+                characterAt(characters, target).takeDamage(amount);
+            } else if (action == "heal") {
+                int target, amount;
+                ss >> target >> amount;
+                characterAt(characters, target).heal(amount);
+            } else if (action == "status") {
+                int target, turns;
+                ss >> target >> turns;
+                characterAt(characters, target).applyStatusEffect(restOfLine(ss), turns);
+            } else if (action == "use") {
+                int index, count;
+                ss >> index >> count;
+                characterAt(characters, index).useItem(restOfLine(ss), count);
+            } else if (action == "turn") {
+                for (auto& character : characters) {
+                    character.processTurn();
+                }
+            } else {
+                throw std::domain_error("unknown action " + action);
+            }
+
+            if (ss.fail()) {
+                throw std::domain_error("malformed action: " + line);
+            }
+        }
+
+        for (auto& character : characters) {
+            CharacterOutcome outcome;
+            outcome.health = character.getHealth();
+            outcome.maxHealth = character.getMaxHealth();
+            outcome.level = character.getLevel();
+            outcome.dead = character.isDead();
+            result.characters.push_back(outcome);
+        }
+        result.ok = true;
+    } catch (const std::exception& e) {
+        result.ok = false;
+        result.error = e.what();
+        result.characters.clear();
+    }
+
+    return result;
+}
+
+// client
+SimulationClient::SimulationClient(const std::string& socketPath) {
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw systemError("socket");
+    }
+
+    sockaddr_un address = socketAddress(socketPath);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        std::runtime_error error = systemError("connect " + socketPath);
+        ::close(fd);
+        throw error;
+    }
+}
+
+SimulationClient::~SimulationClient() { ::close(fd); }
+
+void SimulationClient::send(const SimulationRequest& request) {
+    if (!writeFrame(fd, request.encode())) {
+        throw systemError("send");
+    }
+}
+
+SimulationResult SimulationClient::receive() {
+    std::string payload;
+    if (!readFrame(fd, payload)) {
+        throw std::runtime_error("simulation server closed the connection");
+    }
+
+    return SimulationResult::decode(payload);
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "character.h"
+
+// one encounter to simulate. characters are either serialized payloads (with
+// their current and max health, which serialize does not carry) or copies of
+// a named archetype kept warm on the server. the script is one action per line:
+//   attack <attacker> <target>
+//   ability <caster> <target> <ability>
+//   damage <target> <amount>
+//   heal <target> <amount>
+//   status <target> <turns> <effect>
+//   use <character> <count> <item>
+//   turn
+// indices refer to the order characters were added; names run to the end of
+// the line so they may contain spaces. critical hits are rolled from a
+// generator seeded per request (the id unless set), so a request's result
+// does not depend on what else the server is running.
+class SimulationRequest {
+private:
+    struct CharacterSpec {
+        bool fromArchetype{};
+        std::string archetype{};
+        std::string name{};
+        int health{};
+        int maxHealth{};
+        std::string payload{};
+    };
+
+    std::uint64_t id{};
+    std::uint64_t seed{};
+    std::vector<CharacterSpec> characters{};
+    std::vector<std::string> script{};
+
+public:
+    SimulationRequest() {}
+    explicit SimulationRequest(std::uint64_t id);
+
+    // max health is taken from the character
+    void addCharacter(const Character& character, int health);
+    void addArchetype(const std::string& archetype, const std::string& name);
+    void addAction(const std::string& action);
+    void setSeed(std::uint64_t seed);
+
+    std::uint64_t getId() const;
+    std::uint64_t getSeed() const;
+    int getCharacterCount() const;
+    int getActionCount() const;
+
+    std::string encode() const;
+    static SimulationRequest decode(const std::string& data);
+
+    friend class SimulationServer;
+};
+
+struct CharacterOutcome {
+    int health{};
+    int maxHealth{};
+    int level{};
+    bool dead{};
+};
+
+struct SimulationResult {
+    std::uint64_t id{};
+    bool ok{};
+    std::string error{};
+    std::vector<CharacterOutcome> characters{};
+
+    std::string encode() const;
+    static SimulationResult decode(const std::string& data);
+};
+
+// long-running simulation service on a unix domain socket. every connection
+// may pipeline length-prefixed requests; they run on a shared worker pool and
+// each result is queued for the connection's writer as soon as it completes,
+// so results can arrive out of order (match them by id). a connection with
+// too many unanswered requests is not read from until its client takes some
+// results, so a client that pipelines thousands of requests must read
+// results while it sends.
+class SimulationServer {
+private:
+    struct Connection;
+
+    std::string socketPath{};
+    unsigned workerCount{};
+    int listenFd{-1};
+    std::atomic<bool> running{false};
+    std::atomic<std::uint64_t> completedJobs{0};
+
+    std::map<std::string, Character> archetypes{};
+    std::map<std::string, std::function<bool(Character&, Character&)>> abilities{};
+    std::map<std::string, std::shared_ptr<const AbilityProgram>> scriptedAbilities{};
+
+    std::thread acceptThread{};
+    std::vector<std::thread> workers{};
+    std::mutex connectionsMutex{};
+    std::vector<std::shared_ptr<Connection>> connections{};
+
+    std::mutex jobsMutex{};
+    std::condition_variable jobsReady{};
+    std::deque<std::function<void()>> jobs{};
+
+    void acceptLoop();
+    void readLoop(std::shared_ptr<Connection> connection);
+    void writeLoop(std::shared_ptr<Connection> connection);
+    void workerLoop();
+    void enqueue(std::function<void()> job);
+
+public:
+    // workers = 0 uses one worker per core
+    explicit SimulationServer(const std::string& socketPath, unsigned workers = 0);
+    ~SimulationServer();
+
+    SimulationServer(const SimulationServer&) = delete;
+    SimulationServer& operator=(const SimulationServer&) = delete;
+
+    // archetypes and abilities must be registered before start. the built-in
+    // Warrior, Mage and Rogue archetypes and the library abilities (Fireball,
+    // Heal, Poison Strike, Fire Breath, all scripted) are registered by the
+    // constructor.
+    void registerArchetype(const std::string& name, const Character& character);
+    void registerAbility(const std::string& name,
+                         std::function<bool(Character&, Character&)> ability);
+    // compiles source with AbilityProgram::compile
+    void registerAbility(const std::string& name, const std::string& source);
+
+    void start();
+    void stop();
+    bool isRunning() const;
+    std::uint64_t getCompletedJobs() const;
+
+    // runs one request on the calling thread against the warm registries
+    SimulationResult run(const SimulationRequest& request) const;
+};
+
+// blocking client for SimulationServer. send does not wait for results, so
+// many requests can be in flight on one connection.
+class SimulationClient {
+private:
+    int fd{-1};
+
+public:
+    explicit SimulationClient(const std::string& socketPath);
+    ~SimulationClient();
+
+    SimulationClient(const SimulationClient&) = delete;
+    SimulationClient& operator=(const SimulationClient&) = delete;
+
+    void send(const SimulationRequest& request);
+    SimulationResult receive();
+};
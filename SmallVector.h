@@ -0,0 +1,132 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+// vector that keeps the first N elements inline and only touches the heap
+// once it grows past them. restricted to trivially copyable types so growth
+// and copies are plain memcpy calls.
+template <typename T, std::size_t N>
+class SmallVector {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SmallVector only holds trivially copyable types");
+    static_assert(N > 0, "SmallVector needs at least one inline slot");
+
+private:
+    T* elements{reinterpret_cast<T*>(inlineStorage)};
+    std::size_t length{};
+    std::size_t reserved{N};
+    alignas(T) unsigned char inlineStorage[N * sizeof(T)]{};
+
+    bool isInline() const {
+        return elements == reinterpret_cast<const T*>(inlineStorage);
+    }
+
+    void grow(std::size_t minimum) {
+        std::size_t newCapacity = reserved * 2;
+        if (newCapacity < minimum) {
+            newCapacity = minimum;
+        }
+
+        T* heap = static_cast<T*>(std::malloc(newCapacity * sizeof(T)));
+        if (heap == nullptr) {
+            throw std::bad_alloc();
+        }
+        std::memcpy(static_cast<void*>(heap), elements, length * sizeof(T));
+
+        release();
+        elements = heap;
+        reserved = newCapacity;
+    }
+
+    void release() {
+        if (!isInline()) {
+            std::free(elements);
+        }
+        elements = reinterpret_cast<T*>(inlineStorage);
+        reserved = N;
+    }
+
+    void copyFrom(const SmallVector& other) {
+        if (other.length > reserved) {
+            grow(other.length);
+        }
+        std::memcpy(static_cast<void*>(elements), other.elements,
+                    other.length * sizeof(T));
+        length = other.length;
+    }
+
+    void moveFrom(SmallVector& other) {
+        if (other.isInline()) {
+            copyFrom(other);
+        } else {
+            elements = other.elements;
+            reserved = other.reserved;
+            length = other.length;
+            other.elements = reinterpret_cast<T*>(other.inlineStorage);
+            other.reserved = N;
+        }
+        other.length = 0;
+    }
+
+public:
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() {}
+    SmallVector(const SmallVector& other) { copyFrom(other); }
+    SmallVector(SmallVector&& other) noexcept { moveFrom(other); }
+    ~SmallVector() { release(); }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            length = 0;
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept {
+        if (this != &other) {
+            release();
+            length = 0;
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    std::size_t size() const { return length; }
+    std::size_t capacity() const { return reserved; }
+    bool empty() const { return length == 0; }
+    bool usesInlineStorage() const { return isInline(); }
+
+    T& operator[](std::size_t index) { return elements[index]; }
+    const T& operator[](std::size_t index) const { return elements[index]; }
+
+    iterator begin() { return elements; }
+    iterator end() { return elements + length; }
+    const_iterator begin() const { return elements; }
+    const_iterator end() const { return elements + length; }
+
+    void push_back(const T& value) {
+        if (length == reserved) {
+            // value may live inside this vector, so copy it before growing
+            T copy = value;
+            grow(length + 1);
+            elements[length++] = copy;
+            return;
+        }
+        elements[length++] = value;
+    }
+
+    // removes the element at position by moving the last element into it;
+    // element order is not preserved
+    void swapErase(iterator position) {
+        *position = elements[length - 1];
+        --length;
+    }
+
+    void clear() { length = 0; }
+};
@@ -0,0 +1,43 @@
+#include "StatRegistry.h"
+
+#include <mutex>
+#include <stdexcept>
+
+StatRegistry& StatRegistry::global() {
+    static StatRegistry registry;
+    return registry;
+}
+
+StatId StatRegistry::idFor(const std::string& name) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = idsByName.find(name);
+        if (it != idsByName.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+
+    // another thread may have registered it between the two locks
+    auto it = idsByName.find(name);
+    if (it != idsByName.end()) {
+        return it->second;
+    }
+
+    StatId id = static_cast<StatId>(names.size());
+    names.push_back(name);
+    idsByName[name] = id;
+
+    return id;
+}
+
+std::string StatRegistry::nameOf(StatId id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+
+    if (id >= names.size()) {
+        throw std::out_of_range("unknown stat id");
+    }
+
+    return names[id];
+}
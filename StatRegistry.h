@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+using StatId = std::uint32_t;
+
+// process-wide registry of stat names. each name gets a dense id the first
+// time it is seen, so hot paths such as compiled abilities can read a
+// character's stats by index instead of looking the name up in its map.
+class StatRegistry {
+private:
+    mutable std::shared_mutex mutex{};
+    std::deque<std::string> names{};
+    std::unordered_map<std::string, StatId> idsByName{};
+
+public:
+    static StatRegistry& global();
+
+    // returns the id for name, registering it if unknown
+    StatId idFor(const std::string& name);
+
+    std::string nameOf(StatId id) const;
+};
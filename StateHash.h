@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// zobrist-style keys for incremental state hashing. a character's hash is the
+// xor of one key per (field, subject, value) it holds, so a mutation updates it
+// by xoring out the old key and xoring in the new one. keys depend only on
+// names and values, never on process-local ids or std::hash, so two processes
+// in lockstep produce identical hashes.
+namespace statehash {
+
+enum class Tag : std::uint64_t {
+    Name = 1,
+    Health,
+    MaxHealth,
+    Experience,
+    Level,
+    Stat,
+    Item,
+    Gear,
+    WeaponDamage,
+    StatusEffect,
+    Turn,
+    CriticalRate,
+    CriticalMultiplier,
+    Member
+};
+
+// splitmix64 finalizer
+inline std::uint64_t mix(std::uint64_t value) {
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+// 64-bit FNV-1a of a name, used as the subject of keyed fields
+inline std::uint64_t ofString(const std::string& value) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char c : value) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+inline std::uint64_t key(Tag tag, std::uint64_t subject, std::int64_t value) {
+    return mix(mix(static_cast<std::uint64_t>(tag) ^ mix(subject)) ^
+               static_cast<std::uint64_t>(value));
+}
+
+// key for a field without a subject (health, level, ...)
+inline std::uint64_t key(Tag tag, std::int64_t value) { return key(tag, 0, value); }
+
+}  // namespace statehash
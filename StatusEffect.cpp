@@ -0,0 +1,94 @@
+#include "StatusEffect.h"
+
+#include <mutex>
+#include <stdexcept>
+
+#include "StateHash.h"
+#include "character.h"
+
+StatusEffectManager::StatusEffectManager() {
+    defineEffect("Poison", [](Character& character) { character.takeDamage(5); });
+}
+
+StatusEffectManager& StatusEffectManager::global() {
+    static StatusEffectManager manager;
+    return manager;
+}
+
+StatusEffectId StatusEffectManager::defineEffect(const std::string& name,
+                                                 std::function<void(Character&)> onTurn) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+
+    auto it = idsByName.find(name);
+    if (it != idsByName.end()) {
+        definitions[it->second].onTurn = onTurn;
+        return it->second;
+    }
+
+    StatusEffectId id = static_cast<StatusEffectId>(definitions.size());
+    definitions.push_back({name, onTurn, statehash::ofString(name)});
+    idsByName[name] = id;
+
+    return id;
+}
+
+StatusEffectId StatusEffectManager::idFor(const std::string& name) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = idsByName.find(name);
+        if (it != idsByName.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+
+    // another thread may have registered it between the two locks
+    auto it = idsByName.find(name);
+    if (it != idsByName.end()) {
+        return it->second;
+    }
+
+    StatusEffectId id = static_cast<StatusEffectId>(definitions.size());
+    definitions.push_back({name, nullptr, statehash::ofString(name)});
+    idsByName[name] = id;
+
+    return id;
+}
+
+bool StatusEffectManager::find(const std::string& name, StatusEffectId& id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+
+    auto it = idsByName.find(name);
+    if (it == idsByName.end()) {
+        return false;
+    }
+
+    id = it->second;
+    return true;
+}
+
+std::string StatusEffectManager::nameOf(StatusEffectId id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+
+    if (id >= definitions.size()) {
+        throw std::out_of_range("unknown status effect id");
+    }
+
+    return definitions[id].name;
+}
+
+bool StatusEffectManager::ticks(StatusEffectId id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return id < definitions.size() && definitions[id].onTurn != nullptr;
+}
+
+std::function<void(Character&)> StatusEffectManager::onTurnOf(StatusEffectId id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return id < definitions.size() ? definitions[id].onTurn : nullptr;
+}
+
+std::uint64_t StatusEffectManager::hashKeyOf(StatusEffectId id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return id < definitions.size() ? definitions[id].hashKey : 0;
+}
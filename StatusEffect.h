@@ -1,17 +1,48 @@
 #pragma once
+#include <cstdint>
+#include <deque>
 #include <functional>
-#include <map>
+#include <shared_mutex>
 #include <string>
-
-#include "character.h"
+#include <unordered_map>
 
 class Character;
 
+using StatusEffectId = std::uint32_t;
+
+// process-wide registry of status effects. effects with an onTurn handler run
+// it every turn they are active; effects without one (buffs, or any name first
+// seen through applyStatusEffect) are passive and cost nothing per turn.
 class StatusEffectManager {
-   public:
-    static std::map<std::string, std::function<void(Character&)>>
-    getStatusEffects() {
-        return {
-            {"Poison", [](Character& character) { character.takeDamage(5); }}};
-    }
-};
\ No newline at end of file
+private:
+    struct Definition {
+        std::string name{};
+        std::function<void(Character&)> onTurn{};
+        std::uint64_t hashKey{};
+    };
+
+    mutable std::shared_mutex mutex{};
+    std::deque<Definition> definitions{};
+    std::unordered_map<std::string, StatusEffectId> idsByName{};
+
+    StatusEffectManager();
+
+public:
+    static StatusEffectManager& global();
+
+    // registers a new effect or replaces the handler of an existing one
+    StatusEffectId defineEffect(const std::string& name,
+                                std::function<void(Character&)> onTurn);
+
+    // returns the id for name, registering it as passive if unknown
+    StatusEffectId idFor(const std::string& name);
+
+    // looks up name without registering it
+    bool find(const std::string& name, StatusEffectId& id) const;
+
+    std::string nameOf(StatusEffectId id) const;
+    bool ticks(StatusEffectId id) const;
+    std::function<void(Character&)> onTurnOf(StatusEffectId id) const;
+    // statehash::ofString of the effect name
+    std::uint64_t hashKeyOf(StatusEffectId id) const;
+};
@@ -0,0 +1,69 @@
+#include "StringTable.h"
+
+#include <stdexcept>
+
+#include "BinaryCodec.h"
+
+std::uint32_t StringTableWriter::intern(const std::string& value) {
+    auto it = ids.find(value);
+    if (it != ids.end()) {
+        return it->second;
+    }
+
+    std::uint32_t id = static_cast<std::uint32_t>(strings.size());
+    strings.push_back(value);
+    ids.emplace(value, id);
+    return id;
+}
+
+void StringTableWriter::write(std::string& out) const {
+    binary::putVarUint(out, strings.size());
+    for (const auto& value : strings) {
+        binary::putVarUint(out, value.size());
+        out += value;
+    }
+}
+
+size_t StringTableWriter::size() const { return strings.size(); }
+
+StringTableReader StringTableReader::read(const std::string& data, size_t& pos) {
+    StringTableReader table;
+
+    std::uint64_t count = binary::getVarUint(data, pos);
+    // every entry takes at least one byte, so a corrupt count fails here
+    // instead of reserving a huge vector
+    binary::requireBytes(data, pos, count);
+    table.strings.reserve(count);
+
+    for (std::uint64_t i = 0; i < count; i++) {
+        std::uint64_t length = binary::getVarUint(data, pos);
+        binary::requireBytes(data, pos, length);
+        table.strings.push_back(data.substr(pos, length));
+        pos += length;
+    }
+
+    table.itemIds.resize(count);
+    table.itemResolved.resize(count, false);
+    return table;
+}
+
+const std::string& StringTableReader::at(std::uint64_t index) const {
+    if (index >= strings.size()) {
+        throw std::domain_error("string table index out of range");
+    }
+
+    return strings[index];
+}
+
+ItemId StringTableReader::itemAt(std::uint64_t index) {
+    const std::string& name = at(index);
+
+    if (!itemResolved[index]) {
+        itemIds[index] = ItemCatalog::global().idFor(name);
+        itemResolved[index] = true;
+    }
+
+    return itemIds[index];
+}
+
+size_t StringTableReader::size() const { return strings.size(); }
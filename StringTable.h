@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ItemCatalog.h"
+
+// shared string dictionary for binary save formats. a writer interns every
+// name once and records store the returned index; the table is written ahead
+// of the records so a reader can resolve indices in a single pass.
+class StringTableWriter {
+private:
+    std::unordered_map<std::string, std::uint32_t> ids{};
+    std::vector<std::string> strings{};
+
+public:
+    std::uint32_t intern(const std::string& value);
+    void write(std::string& out) const;
+    size_t size() const;
+};
+
+class StringTableReader {
+private:
+    std::vector<std::string> strings{};
+    // item ids resolved on first use, so each name hits the catalog once
+    std::vector<ItemId> itemIds{};
+    std::vector<bool> itemResolved{};
+
+public:
+    static StringTableReader read(const std::string& data, size_t& pos);
+
+    // both throw std::domain_error for an index outside the table
+    const std::string& at(std::uint64_t index) const;
+    ItemId itemAt(std::uint64_t index);
+
+    size_t size() const;
+};
@@ -1,10 +1,140 @@
 #include "TestRunner.h"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <sstream>
+#include <thread>
+
+namespace {
+thread_local std::ostringstream* currentLog = nullptr;
+}
+
+std::ostream& TestRunner::log() {
+    if (currentLog != nullptr) {
+        return *currentLog;
+    }
+
+    return std::cout;
+}
+
+TestResult TestRunner::execute(const TestCase& testCase) {
+    TestResult result{};
+    result.name = testCase.name;
+
+    // restored afterwards, since a test may run a nested runner on this thread
+    std::ostringstream output;
+    std::ostringstream* outerLog = currentLog;
+    currentLog = &output;
+
+    auto start = std::chrono::steady_clock::now();
+    try {
+        result.passed = testCase.test();
+    } catch (const std::exception& e) {
+        output << "Unhandled exception: " << e.what() << std::endl;
+        result.passed = false;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    currentLog = outerLog;
+
+    result.elapsed =
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+    if (testCase.budget != std::chrono::milliseconds::zero() &&
+        result.elapsed > testCase.budget) {
+        output << "Time budget exceeded: " << result.elapsed.count() / 1000.0
+               << "ms > " << testCase.budget.count() << "ms" << std::endl;
+        result.overBudget = true;
+        result.passed = false;
+    }
+
+    result.output = output.str();
+    return result;
+}
+
+void TestRunner::report(const TestResult& result) {
+    log() << "Running test: " << result.name << "..."
+              << (result.passed ? "PASSED" : "FAILED") << " ("
+              << result.elapsed.count() / 1000.0 << "ms)" << std::endl;
+    // assertion output is only interesting when something went wrong
+    if (!result.passed) {
+        log() << result.output;
+    }
+}
+
 void TestRunner::runTest(const std::string& testName, std::function<bool()> test) {
-    std::cout << "Running test: " << testName << "...";
-    if (test()) {
-        std::cout << "PASSED" << std::endl;
-    } else {
-        std::cout << "FAILED" << std::endl;
+    report(execute({testName, test, std::chrono::milliseconds::zero(), false}));
+}
+
+void TestRunner::addTest(const std::string& testName, std::function<bool()> test,
+                         std::chrono::milliseconds budget) {
+    tests.push_back({testName, test, budget, budget != std::chrono::milliseconds::zero()});
+}
+
+void TestRunner::addSerialTest(const std::string& testName, std::function<bool()> test) {
+    tests.push_back({testName, test, std::chrono::milliseconds::zero(), true});
+}
+
+int TestRunner::runAll(unsigned workerCount) {
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::vector<size_t> parallel;
+    std::vector<size_t> serial;
+    for (size_t index = 0; index < tests.size(); index++) {
+        (tests[index].serial ? serial : parallel).push_back(index);
+    }
+    workerCount = std::min<unsigned>(workerCount, std::max<size_t>(1, parallel.size()));
+
+    results.assign(tests.size(), TestResult{});
+    std::atomic<size_t> nextTest{0};
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < workerCount; i++) {
+        workers.emplace_back([this, &parallel, &nextTest]() {
+            for (size_t next = nextTest++; next < parallel.size(); next = nextTest++) {
+                results[parallel[next]] = execute(tests[parallel[next]]);
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
     }
-}
\ No newline at end of file
+
+    // serial tests run alone once the parallel phase has finished
+    for (size_t index : serial) {
+        results[index] = execute(tests[index]);
+    }
+
+    auto wallTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    int failed = 0;
+    int overBudget = 0;
+    for (const auto& result : results) {
+        report(result);
+        if (!result.passed) {
+            failed++;
+        }
+        if (result.overBudget) {
+            overBudget++;
+        }
+    }
+
+    log() << "\n" << results.size() << " tests, "
+              << results.size() - failed << " passed, " << failed << " failed";
+    if (overBudget > 0) {
+        log() << " (" << overBudget << " over time budget)";
+    }
+    log() << " in " << wallTime.count() / 1000.0 << "ms on " << workerCount
+              << " threads" << std::endl;
+
+    return failed;
+}
+
+const std::vector<TestResult>& TestRunner::getResults() const { return results; }
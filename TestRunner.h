@@ -1,13 +1,54 @@
 #pragma once
+#include <chrono>
+#include <functional>
 #include <iostream>
 #include <string>
-#include <functional>
+#include <vector>
+
+struct TestResult {
+    std::string name{};
+    bool passed{};
+    bool overBudget{};
+    std::chrono::microseconds elapsed{};
+    std::string output{};
+};
 
 class TestRunner {
+    private:
+     struct TestCase {
+         std::string name{};
+         std::function<bool()> test{};
+         std::chrono::milliseconds budget{};
+         bool serial{};
+     };
+
+     std::vector<TestCase> tests{};
+     std::vector<TestResult> results{};
+
+     static TestResult execute(const TestCase& testCase);
+     static void report(const TestResult& result);
+
     public:
      static void runTest(const std::string& testName, std::function<bool()> test);
+
+     // queue a test for runAll. a non-zero budget fails the test if its wall
+     // time exceeds it; budgeted tests run serially so the timing is their own.
+     void addTest(const std::string& testName, std::function<bool()> test,
+                  std::chrono::milliseconds budget = std::chrono::milliseconds::zero());
+     // queue a test that must not overlap any other, e.g. one that checks
+     // shared global state
+     void addSerialTest(const std::string& testName, std::function<bool()> test);
+
+     // runs every queued test across workerCount threads (0 = one per core),
+     // then the serial ones one at a time, prints the results in registration
+     // order plus a summary and returns the number of failed tests
+     int runAll(unsigned workerCount = 0);
+     const std::vector<TestResult>& getResults() const;
+
+     // stream assertions write to; buffered per test while a test is running
+     static std::ostream& log();
  };
- 
- #define ASSERT_EQ(expected, actual)   \                                       
-     ((expected) == (actual)) ? true : \
-     (std::cout << "Assertion failed: " << expected << " != " << actual << std::endl,  false)
\ No newline at end of file
+
+#define ASSERT_EQ(expected, actual)    \
+    (((expected) == (actual)) ? true : \
+     (TestRunner::log() << "Assertion failed: " << (expected) << " != " << (actual) << std::endl, false))
@@ -0,0 +1,84 @@
+#include "TimingWheel.h"
+
+#include <algorithm>
+
+void TimingWheel::place(const TimerEntry& entry) {
+    long long delta = static_cast<long long>(entry.expiry) - now;
+
+    // already due: pick it up on the next advance
+    if (delta <= 0) {
+        buckets[(now + 1) & (SLOTS - 1)].push_back(entry);
+        return;
+    }
+
+    for (int level = 0; level < LEVELS; level++) {
+        if (delta < (1LL << (SLOT_BITS * (level + 1)))) {
+            int slot = (entry.expiry >> (SLOT_BITS * level)) & (SLOTS - 1);
+            buckets[level * SLOTS + slot].push_back(entry);
+            return;
+        }
+    }
+
+    overflow.push_back(entry);
+}
+
+void TimingWheel::cascade(std::vector<TimerEntry>& bucket) {
+    std::vector<TimerEntry> entries;
+    entries.swap(bucket);
+
+    // cascades run after now has moved to the new turn but before its slot is
+    // drained, so entries due this turn go into that slot rather than the next
+    for (const auto& entry : entries) {
+        if (entry.expiry <= now) {
+            buckets[now & (SLOTS - 1)].push_back(entry);
+        } else {
+            place(entry);
+        }
+    }
+}
+
+void TimingWheel::schedule(std::uint32_t id, int expiry) {
+    entryCount++;
+
+    if (buckets.empty()) {
+        if (static_cast<int>(list.size()) < LIST_LIMIT) {
+            auto it = std::upper_bound(
+                list.begin(), list.end(), expiry,
+                [](int key, const TimerEntry& entry) { return key > entry.expiry; });
+            list.insert(it, {id, expiry});
+            return;
+        }
+
+        // too many for the list: move everything into the slots
+        buckets.resize(LEVELS * SLOTS);
+        for (const auto& entry : list) {
+            place(entry);
+        }
+        list.clear();
+        list.shrink_to_fit();
+    }
+
+    place({id, expiry});
+}
+
+void TimingWheel::reset(int turn) {
+    now = turn;
+    entryCount = 0;
+    list.clear();
+    buckets.clear();
+    overflow.clear();
+}
+
+int TimingWheel::getNow() const { return now; }
+
+int TimingWheel::size() const { return entryCount; }
+
+size_t TimingWheel::getHeapBytes() const {
+    size_t bytes = list.capacity() * sizeof(TimerEntry) +
+                   buckets.capacity() * sizeof(std::vector<TimerEntry>) +
+                   overflow.capacity() * sizeof(TimerEntry);
+    for (const auto& bucket : buckets) {
+        bytes += bucket.capacity() * sizeof(TimerEntry);
+    }
+    return bytes;
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct TimerEntry {
+    std::uint32_t id{};
+    int expiry{};
+};
+
+// hierarchical timing wheel keyed by absolute turn number. level 0 has one
+// slot per turn for the next 16 turns, each level above covers 16 times the
+// span of the one below, and anything further out waits in an overflow list.
+// advancing a turn only touches the entries in the slot for that turn (plus an
+// occasional cascade), so the cost follows the number of timers due rather
+// than the number scheduled.
+//
+// most owners only ever have a handful of timers, so the slots are not
+// allocated until more than LIST_LIMIT are pending at once. until then the
+// entries live in one short list sorted by expiry.
+//
+// entries are never cancelled; owners keep the authoritative expiry elsewhere
+// and ignore stale entries when they fire.
+class TimingWheel {
+public:
+    static constexpr int SLOT_BITS = 4;
+    static constexpr int SLOTS = 1 << SLOT_BITS;
+    static constexpr int LEVELS = 4;
+    static constexpr int LIST_LIMIT = 8;
+
+private:
+    int now{};
+    int entryCount{};
+    // latest expiry first, so due entries are popped off the back
+    std::vector<TimerEntry> list{};
+    std::vector<std::vector<TimerEntry>> buckets{};
+    std::vector<TimerEntry> overflow{};
+
+    void place(const TimerEntry& entry);
+    void cascade(std::vector<TimerEntry>& bucket);
+
+public:
+    void schedule(std::uint32_t id, int expiry);
+
+    // moves the wheel forward to turn, calling fire(entry) for every entry
+    // whose expiry has been reached
+    template <typename Fire>
+    void advanceTo(int turn, Fire fire);
+
+    // drops every entry and moves the wheel to turn. used after a rollback,
+    // where the owner reschedules from its own expiries.
+    void reset(int turn);
+
+    int getNow() const;
+    int size() const;
+    // bytes held by the list and the bucket vectors
+    size_t getHeapBytes() const;
+};
+
+template <typename Fire>
+void TimingWheel::advanceTo(int turn, Fire fire) {
+    if (entryCount == 0) {
+        now = turn;
+        return;
+    }
+
+    // fire may schedule, which can move the list into the slots
+    while (buckets.empty() && !list.empty() && list.back().expiry <= turn) {
+        TimerEntry entry = list.back();
+        list.pop_back();
+        entryCount--;
+        if (entry.expiry > now) {
+            now = entry.expiry;
+        }
+        fire(entry);
+    }
+    if (buckets.empty()) {
+        now = turn;
+        return;
+    }
+
+    while (now < turn) {
+        now++;
+
+        if (now % (1 << (SLOT_BITS * LEVELS)) == 0) {
+            cascade(overflow);
+        }
+
+        // higher levels first so their entries can land in lower slots that
+        // are due this same turn
+        for (int level = LEVELS - 1; level >= 1; level--) {
+            if (now % (1 << (SLOT_BITS * level)) == 0) {
+                int slot = (now >> (SLOT_BITS * level)) & (SLOTS - 1);
+                cascade(buckets[level * SLOTS + slot]);
+            }
+        }
+
+        std::vector<TimerEntry> due;
+        due.swap(buckets[now & (SLOTS - 1)]);
+        entryCount -= static_cast<int>(due.size());
+
+        for (const auto& entry : due) {
+            if (entry.expiry <= now) {
+                fire(entry);
+            } else {
+                schedule(entry.id, entry.expiry);
+            }
+        }
+
+        if (entryCount == 0) {
+            now = turn;
+        }
+    }
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <functional>
 #include <iostream>
@@ -7,11 +8,16 @@
 #include <string>
 
 #include "CombatSystem.h"
+#include "BinaryCodec.h"
 #include "StatusEffect.h"
+#include "StringTable.h"
+#include "character.h"
 
-Character::Character() {}
+Character::Character() { stateHash = computeStateHash(); }
 Character::Character(std::string name, int health)
-    : name{name}, maxHealth{health}, currentHealth{health} {}
+    : name{name}, maxHealth{health}, currentHealth{health} {
+    stateHash = computeStateHash();
+}
 
 Character Character::createWarrior(const std::string& name) {
     Character warrior = Character(name, 100);
@@ -43,78 +49,250 @@ Character Character::createRogue(const std::string& name) {
     return rogue;
 }
 
-void Character::setName(std::string value) { name = value; }
+void Character::setName(std::string value) {
+    toggleHash(statehash::Tag::Name, statehash::ofString(name), 0);
+    name = value;
+    toggleHash(statehash::Tag::Name, statehash::ofString(name), 0);
+}
 
-std::string Character::getName() { return name; }
+std::string Character::getName() const { return name; }
 
 // level
-int Character::getLevel() { return level; }
+int Character::getLevel() const { return level; }
 
 void Character::gainExperience(int exp) {
-    int totalExperience = experience += exp;
+    if (MutationJournal* journal = journalLink.get()) {
+        journal->recordValue(this, JournalField::Experience, experience);
+        journal->recordValue(this, JournalField::Level, level);
+        journal->recordValue(this, JournalField::MaxHealth, maxHealth);
+    }
+
+    int totalExperience = experience + exp;
+    int newLevel = totalExperience / 100 + 1;
 
-    level = totalExperience / 100 + 1;
-    experience = totalExperience - ((level - 1) * 100);
+    assignHashed(level, statehash::Tag::Level, newLevel);
+    assignHashed(experience, statehash::Tag::Experience,
+                 totalExperience - ((newLevel - 1) * 100));
+    assignHashed(maxHealth, statehash::Tag::MaxHealth, (newLevel - 1) * 10 + 100);
 
-    maxHealth = (level - 1) * 10 + 100;
+    invalidateDerivedStats();
 }
 
-int Character::getExperience() { return experience; }
+int Character::getExperience() const { return experience; }
 
 // hp system
-void Character::setHealth(int value) { maxHealth = value; }
+void Character::setHealth(int value) {
+    if (MutationJournal* journal = journalLink.get()) {
+        journal->recordValue(this, JournalField::MaxHealth, maxHealth);
+    }
+
+    assignHashed(maxHealth, statehash::Tag::MaxHealth, value);
+}
 
-int Character::getHealth() { return currentHealth; }
+int Character::getHealth() const { return currentHealth; }
 
-int Character::getMaxHealth() { return maxHealth; }
+int Character::getMaxHealth() const { return maxHealth; }
 
 void Character::takeDamage(int value) {
-    currentHealth = std::max(0, currentHealth - value);
+    if (MutationJournal* journal = journalLink.get()) {
+        journal->recordValue(this, JournalField::Health, currentHealth);
+    }
+
+    assignHashed(currentHealth, statehash::Tag::Health, std::max(0, currentHealth - value));
 }
 void Character::heal(int value) {
-    if (currentHealth + value > maxHealth) {
-        currentHealth = maxHealth;
-    } else {
-        currentHealth += value;
+    if (MutationJournal* journal = journalLink.get()) {
+        journal->recordValue(this, JournalField::Health, currentHealth);
     }
+
+    assignHashed(currentHealth, statehash::Tag::Health,
+                 std::min(currentHealth + value, maxHealth));
 }
 
-bool Character::isDead() { return currentHealth == 0; }
+bool Character::isDead() const { return currentHealth == 0; }
 
 // stats
-void Character::setStat(std::string stat, int value) { stats[stat] = value; }
+void Character::setStat(std::string stat, int value) {
+    if (MutationJournal* journal = journalLink.get()) {
+        auto it = stats.find(stat);
+        bool existed = it != stats.end();
+        journal->recordKey(this, JournalField::Stat, stat, existed,
+                           existed ? it->second : 0);
+    }
+
+    std::uint64_t subject = statehash::ofString(stat);
+    auto it = stats.find(stat);
+    if (it != stats.end()) {
+        toggleHash(statehash::Tag::Stat, subject, it->second);
+    }
+
+    storeStat(stat, value);
+    toggleHash(statehash::Tag::Stat, subject, value);
+    invalidateDerivedStats();
+}
+
+int Character::getStat(const std::string& stat) { return statValue(stat); }
+
+void Character::setStat(StatId stat, int value) {
+    setStat(StatRegistry::global().nameOf(stat), value);
+}
+
+int Character::getStat(StatId stat) const {
+    return stat < statSlots.size() ? statSlots[stat] : 0;
+}
+
+void Character::storeStat(const std::string& stat, int value) {
+    stats[stat] = value;
+    setStatSlot(stat, value);
+}
+
+void Character::eraseStat(const std::string& stat) {
+    stats.erase(stat);
+    setStatSlot(stat, 0);
+}
+
+void Character::setStatSlot(const std::string& stat, int value) {
+    StatId id = StatRegistry::global().idFor(stat);
+    if (id >= statSlots.size()) {
+        if (value == 0) {
+            return;
+        }
+        statSlots.resize(id + 1, 0);
+    }
+    statSlots[id] = value;
+}
 
-int Character::getStat(std::string stat) { return stats[stat]; }
+int Character::statValue(const std::string& stat) const {
+    // missing stats read as 0 without being inserted
+    auto it = stats.find(stat);
+    return it != stats.end() ? it->second : 0;
+}
 
 // items
+ItemStack* Character::findStack(ItemId item) {
+    for (auto& stack : inventory) {
+        if (stack.item == item) {
+            return &stack;
+        }
+    }
+
+    return nullptr;
+}
+
+const ItemStack* Character::findStack(ItemId item) const {
+    for (const auto& stack : inventory) {
+        if (stack.item == item) {
+            return &stack;
+        }
+    }
+
+    return nullptr;
+}
+
+const ItemStack* Character::findStack(const std::string& item) const {
+    // unknown names are never registered by a lookup
+    ItemId id;
+    if (!ItemCatalog::global().find(item, id)) {
+        return nullptr;
+    }
+
+    return findStack(id);
+}
+
 void Character::equip(std::string item, std::string slot) {
-    if (inventory.find(item) == inventory.end()) {
+    const ItemStack* stack = findStack(item);
+    if (stack == nullptr) {
         throw std::domain_error("cannot equip items not in inventory");
     }
 
-    gear[slot] = item;
+    if (MutationJournal* journal = journalLink.get()) {
+        auto it = gear.find(slot);
+        bool existed = it != gear.end();
+        journal->recordGear(this, slot, existed, existed ? it->second : 0);
+    }
+
+    std::uint64_t subject = statehash::ofString(slot);
+    auto it = gear.find(slot);
+    if (it != gear.end()) {
+        toggleHash(statehash::Tag::Gear, subject, ItemCatalog::global().hashKeyOf(it->second));
+    }
+
+    gear[slot] = stack->item;
+    toggleHash(statehash::Tag::Gear, subject, ItemCatalog::global().hashKeyOf(stack->item));
+    invalidateDerivedStats();
+}
+
+std::string Character::getEquipped(std::string slot) {
+    auto it = gear.find(slot);
+    if (it == gear.end()) {
+        return "";
+    }
+
+    return ItemCatalog::global().nameOf(it->second);
+}
+
+void Character::addToInventory(const std::string& item, int count) {
+    addToInventory(ItemCatalog::global().idFor(item), count);
 }
 
-std::string Character::getEquipped(std::string slot) { return gear[slot]; }
+void Character::addToInventory(ItemId id, int count) {
+    int stackLimit = ItemCatalog::global().stackLimitOf(id);
 
-void Character::addToInventory(std::string item, int count) {
     // check if item already exists
-    if (inventory.count(item) != 0) {
-        inventory[item] += count;
+    ItemStack* stack = findStack(id);
+
+    if (MutationJournal* journal = journalLink.get()) {
+        journal->recordItem(this, JournalField::Inventory, id, stack != nullptr,
+                            stack != nullptr ? stack->count : 0);
+    }
+
+    std::uint64_t subject = ItemCatalog::global().hashKeyOf(id);
+
+    if (stack != nullptr) {
+        long long total = static_cast<long long>(stack->count) + count;
+        assignHashed(stack->count, statehash::Tag::Item, subject,
+                     static_cast<int>(std::min<long long>(total, stackLimit)));
     } else {
-        inventory[item] = count;
+        int stored = std::min(count, stackLimit);
+        inventory.push_back({id, stored});
+        toggleHash(statehash::Tag::Item, subject, stored);
     }
 }
 
-bool Character::hasItem(std::string item) { return inventory.count(item) > 0; }
+bool Character::hasItem(const std::string& item) const { return findStack(item) != nullptr; }
 
-int Character::getItemCount(std::string item) { return inventory[item]; }
+bool Character::hasItem(ItemId item) const { return findStack(item) != nullptr; }
+
+int Character::getItemCount(const std::string& item) const {
+    const ItemStack* stack = findStack(item);
+    return stack != nullptr ? stack->count : 0;
+}
+
+int Character::getItemCount(ItemId item) const {
+    const ItemStack* stack = findStack(item);
+    return stack != nullptr ? stack->count : 0;
+}
 
 int Character::getInventoryCount() { return static_cast<int>(inventory.size()); }
 
-bool Character::useItem(std::string item, int count) {
-    if (inventory.count(item) != 0 && inventory[item] >= count) {
-        inventory[item] -= count;
+bool Character::useItem(const std::string& item, int count) {
+    ItemId id;
+    if (!ItemCatalog::global().find(item, id)) {
+        return false;
+    }
+
+    return useItem(id, count);
+}
+
+bool Character::useItem(ItemId id, int count) {
+    ItemStack* stack = findStack(id);
+    if (stack != nullptr && stack->count >= count) {
+        if (MutationJournal* journal = journalLink.get()) {
+            journal->recordItem(this, JournalField::Inventory, id, true, stack->count);
+        }
+
+        assignHashed(stack->count, statehash::Tag::Item,
+                     ItemCatalog::global().hashKeyOf(id), stack->count - count);
         return true;
     }
 
@@ -123,68 +301,492 @@ bool Character::useItem(std::string item, int count) {
 
 // combat
 void Character::attack(Character& character) {
+    int rolled = (rand() % 100) + 1;
+
+    resolveAttack(character, rolled > getDerivedStats().critThreshold);
+}
+
+void Character::resolveAttack(Character& character, bool critical) {
+    const DerivedStats& derived = getDerivedStats();
+
+    character.takeDamage(critical ? derived.critDamage : derived.attackPower);
+}
+
+const DerivedStats& Character::getDerivedStats() {
+    // base weapon damage lives in the catalog, so a catalog edit also
+    // invalidates the cache
+    std::uint64_t catalogVersion = ItemCatalog::global().getVersion();
+    if (derivedStatsValid && derivedCatalogVersion == catalogVersion) {
+        return derivedStats;
+    }
+
     // damage = character.stats.strength + weapon.damage
-    int weaponDamage = weaponDamageLookup[gear["Weapon"]];
-    int damage = stats["Strength"] + weaponDamage;
+    auto weapon = gear.find("Weapon");
+    int weaponDamage = weapon != gear.end() ? weaponDamageFor(weapon->second) : 0;
 
-    int targetNumber = 100 - int(critSettings.rate * 100);
-    int rolled = (rand() % 100) + 1;
+    derivedStats.attackPower = statValue("Strength") + weaponDamage;
+    derivedStats.critThreshold = 100 - applyFixedPoint(100, critSettings.rate);
+    derivedStats.critMultiplier = fromFixedPoint(critSettings.modifier);
+    derivedStats.critDamage = applyFixedPoint(derivedStats.attackPower, critSettings.modifier);
 
-    if (rolled > targetNumber) {
-        int modifiedDamage = (int)(damage * critSettings.modifier);
-        character.takeDamage(modifiedDamage);
-    } else {
-        character.takeDamage(damage);
+    derivedStatsValid = true;
+    derivedCatalogVersion = catalogVersion;
+
+    return derivedStats;
+}
+
+void Character::invalidateDerivedStats() { derivedStatsValid = false; }
+
+std::vector<std::pair<std::string, int>> Character::sortedInventory() const {
+    std::vector<std::pair<std::string, int>> stacks;
+    stacks.reserve(inventory.size());
+    for (const auto& stack : inventory) {
+        stacks.push_back({ItemCatalog::global().nameOf(stack.item), stack.count});
+    }
+
+    std::sort(stacks.begin(), stacks.end());
+    return stacks;
+}
+
+int Character::weaponDamageFor(ItemId weapon) const {
+    // per-character overrides win over the catalog's base damage
+    auto it = weaponDamageLookup.find(weapon);
+    if (it != weaponDamageLookup.end()) {
+        return it->second;
     }
+
+    return ItemCatalog::global().weaponDamageOf(weapon);
 }
 
 void Character::setWeaponDamage(std::string weapon, int damage) {
-    weaponDamageLookup[weapon] = damage;
+    ItemId id = ItemCatalog::global().idFor(weapon);
+
+    if (MutationJournal* journal = journalLink.get()) {
+        auto it = weaponDamageLookup.find(id);
+        bool existed = it != weaponDamageLookup.end();
+        journal->recordItem(this, JournalField::WeaponDamage, id, existed,
+                            existed ? it->second : 0);
+    }
+
+    std::uint64_t subject = ItemCatalog::global().hashKeyOf(id);
+    auto it = weaponDamageLookup.find(id);
+    if (it != weaponDamageLookup.end()) {
+        toggleHash(statehash::Tag::WeaponDamage, subject, it->second);
+    }
+
+    weaponDamageLookup[id] = damage;
+    toggleHash(statehash::Tag::WeaponDamage, subject, damage);
+    invalidateDerivedStats();
 }
 
-void Character::setCriticalRate(double critChance) { critSettings.rate = critChance; }
+void Character::setCriticalRate(double critChance) {
+    if (MutationJournal* journal = journalLink.get()) {
+        journal->recordValue(this, JournalField::CriticalRate, critSettings.rate);
+    }
+
+    assignHashed(critSettings.rate, statehash::Tag::CriticalRate, toFixedPoint(critChance));
+    invalidateDerivedStats();
+}
 
 void Character::setCriticalMultiplier(double damageMultiplier) {
-    critSettings.modifier = damageMultiplier;
+    if (MutationJournal* journal = journalLink.get()) {
+        journal->recordValue(this, JournalField::CriticalMultiplier, critSettings.modifier);
+    }
+
+    assignHashed(critSettings.modifier, statehash::Tag::CriticalMultiplier,
+                 toFixedPoint(damageMultiplier));
+    invalidateDerivedStats();
 }
 
+double Character::getCriticalRate() const { return fromFixedPoint(critSettings.rate); }
+
 // abilities
 void Character::learnAbility(std::string ability,
                   std::function<bool(Character&, Character&)> abilityFunction) {
-    abilityLookup[ability] = abilityFunction;
+    abilityLookup[ability] = {abilityFunction, nullptr};
+}
+
+void Character::learnAbility(std::string ability,
+                             std::shared_ptr<const AbilityProgram> program) {
+    abilityLookup[ability] = {nullptr, program};
 }
 
 bool Character::useAbility(std::string ability, Character& target) {
-    if (abilityLookup.find(ability) == abilityLookup.end()) {
+    auto it = abilityLookup.find(ability);
+    if (it == abilityLookup.end()) {
         return false;
     }
 
-    return abilityLookup[ability](*this, target);
+    // hold a reference so relearning the ability mid-run cannot free it
+    if (std::shared_ptr<const AbilityProgram> program = it->second.program) {
+        return program->run(*this, target);
+    }
+
+    return it->second.function(*this, target);
+}
+
+bool Character::hasAbility(const std::string& ability) const {
+    return abilityLookup.count(ability) != 0;
+}
+
+std::shared_ptr<const AbilityProgram> Character::getAbilityProgram(
+    const std::string& ability) const {
+    auto it = abilityLookup.find(ability);
+    return it != abilityLookup.end() ? it->second.program : nullptr;
+}
+
+std::vector<std::string> Character::getAbilityNames() const {
+    std::vector<std::string> names;
+    for (const auto& pair : abilityLookup) {
+        names.push_back(pair.first);
+    }
+
+    return names;
 }
 
 // status effects
 void Character::applyStatusEffect(std::string status, int turnCount) {
-    statusEffects[status] = turnCount;
+    applyStatusEffect(StatusEffectManager::global().idFor(status), turnCount);
+}
+
+void Character::applyStatusEffect(StatusEffectId id, int turnCount) {
+    int expiry = turnCount > 0 ? turn + turnCount : 0;
+
+    if (MutationJournal* journal = journalLink.get()) {
+        int old = effectExpiryOf(id);
+        journal->recordItem(this, JournalField::StatusEffect, id, old != 0, old);
+    }
+
+    storeEffectExpiry(id, expiry);
 }
 
 bool Character::hasStatusEffect(std::string status) {
-    return statusEffects.count(status) != 0;
+    return getStatusEffectTurns(status) > 0;
+}
+
+int Character::getStatusEffectTurns(std::string status) {
+    StatusEffectId id;
+    if (!StatusEffectManager::global().find(status, id)) {
+        return 0;
+    }
+
+    return std::max(0, effectExpiryOf(id) - turn);
+}
+
+bool Character::hasStatusEffect(StatusEffectId id) { return effectExpiryOf(id) > turn; }
+
+std::map<std::string, int> Character::getStatusEffects() const {
+    std::map<std::string, int> effects;
+    for (StatusEffectId id : activeEffects) {
+        int remaining = effectExpiryOf(id) - turn;
+        if (remaining > 0) {
+            effects[StatusEffectManager::global().nameOf(id)] = remaining;
+        }
+    }
+
+    return effects;
+}
+
+int Character::getTurn() const { return turn; }
+
+int Character::effectExpiryOf(StatusEffectId id) const {
+    return id < effectExpiry.size() ? effectExpiry[id] : 0;
+}
+
+void Character::storeEffectExpiry(StatusEffectId id, int expiry) {
+    if (id >= effectExpiry.size()) {
+        effectExpiry.resize(id + 1, 0);
+    }
+
+    int old = effectExpiry[id];
+    effectExpiry[id] = expiry;
+
+    if (old != expiry) {
+        std::uint64_t subject = StatusEffectManager::global().hashKeyOf(id);
+        if (old != 0) {
+            toggleHash(statehash::Tag::StatusEffect, subject, old);
+        }
+        if (expiry != 0) {
+            toggleHash(statehash::Tag::StatusEffect, subject, expiry);
+        }
+    }
+
+    // an effect is listed while it has a non-zero expiry; the wheel clears it
+    // once that turn is reached
+    if (old == 0 && expiry != 0) {
+        activeEffects.push_back(id);
+        if (StatusEffectManager::global().ticks(id)) {
+            tickingEffects.push_back(id);
+        }
+    } else if (old != 0 && expiry == 0) {
+        removeEffectId(activeEffects, id);
+        removeEffectId(tickingEffects, id);
+    }
+
+    if (expiry != 0 && expiry != old) {
+        effectWheel.schedule(id, expiry);
+    }
+}
+
+// effects restored by a rollback were scheduled against the later turn, so
+// start the wheel over from the restored expiries
+void Character::rebuildEffectWheel() {
+    effectWheel.reset(turn);
+    for (StatusEffectId id : activeEffects) {
+        effectWheel.schedule(id, effectExpiryOf(id));
+    }
+}
+
+void Character::removeEffectId(SmallVector<StatusEffectId, 4>& effects, StatusEffectId id) {
+    for (auto it = effects.begin(); it != effects.end(); ++it) {
+        if (*it == id) {
+            effects.swapErase(it);
+            return;
+        }
+    }
 }
 
 // turns
 void Character::processTurn() {
-    // iterate over each status effect, do the associated lambda, then take off
-    // a turn
-    for (auto it = statusEffects.begin(); it != statusEffects.end(); ++it) {
-        // look up the status effect
-        StatusEffectManager::getStatusEffects()[it->first](*this);
+    if (MutationJournal* journal = journalLink.get()) {
+        journal->recordValue(this, JournalField::Turn, turn);
+    }
 
-        statusEffects[it->first] -= 1;
+    assignHashed(turn, statehash::Tag::Turn, turn + 1);
 
-        if (it->second == 0) {
-            statusEffects.erase(it->first);
+    // only effects with a per-turn handler are visited; a handler may apply or
+    // clear effects, so walk a copy of the list
+    SmallVector<StatusEffectId, 4> ticking = tickingEffects;
+    for (StatusEffectId id : ticking) {
+        if (effectExpiryOf(id) >= turn) {
+            StatusEffectManager::global().onTurnOf(id)(*this);
         }
     }
+
+    // expiry work is limited to the wheel slot for this turn
+    effectWheel.advanceTo(turn, [this](const TimerEntry& entry) {
+        // entries left behind by a re-application are stale
+        if (effectExpiryOf(entry.id) != entry.expiry) {
+            return;
+        }
+
+        if (MutationJournal* journal = journalLink.get()) {
+            journal->recordItem(this, JournalField::StatusEffect, entry.id, true,
+                                entry.expiry);
+        }
+
+        storeEffectExpiry(entry.id, 0);
+    });
+}
+
+// undo journal
+void Character::attachJournal(MutationJournal* journal) { journalLink.attach(journal); }
+
+void Character::revert(const JournalEntry& entry) {
+    invalidateDerivedStats();
+
+    switch (entry.field) {
+        case JournalField::Health:
+            assignHashed(currentHealth, statehash::Tag::Health, entry.oldValue);
+            break;
+        case JournalField::MaxHealth:
+            assignHashed(maxHealth, statehash::Tag::MaxHealth, entry.oldValue);
+            break;
+        case JournalField::Experience:
+            assignHashed(experience, statehash::Tag::Experience, entry.oldValue);
+            break;
+        case JournalField::Level:
+            assignHashed(level, statehash::Tag::Level, entry.oldValue);
+            break;
+        case JournalField::Stat: {
+            std::uint64_t subject = statehash::ofString(entry.key);
+            auto it = stats.find(entry.key);
+            if (it != stats.end()) {
+                toggleHash(statehash::Tag::Stat, subject, it->second);
+            }
+
+            if (entry.existed) {
+                storeStat(entry.key, entry.oldValue);
+                toggleHash(statehash::Tag::Stat, subject, entry.oldValue);
+            } else {
+                eraseStat(entry.key);
+            }
+            break;
+        }
+        case JournalField::Inventory: {
+            std::uint64_t subject = ItemCatalog::global().hashKeyOf(entry.item);
+            ItemStack* stack = findStack(entry.item);
+            if (stack != nullptr) {
+                toggleHash(statehash::Tag::Item, subject, stack->count);
+            }
+
+            if (!entry.existed) {
+                if (stack != nullptr) {
+                    inventory.swapErase(stack);
+                }
+                break;
+            }
+
+            if (stack != nullptr) {
+                stack->count = entry.oldValue;
+            } else {
+                inventory.push_back({entry.item, entry.oldValue});
+            }
+            toggleHash(statehash::Tag::Item, subject, entry.oldValue);
+            break;
+        }
+        case JournalField::Gear: {
+            std::uint64_t subject = statehash::ofString(entry.key);
+            auto it = gear.find(entry.key);
+            if (it != gear.end()) {
+                toggleHash(statehash::Tag::Gear, subject,
+                           ItemCatalog::global().hashKeyOf(it->second));
+            }
+
+            if (entry.existed) {
+                gear[entry.key] = entry.item;
+                toggleHash(statehash::Tag::Gear, subject,
+                           ItemCatalog::global().hashKeyOf(entry.item));
+            } else {
+                gear.erase(entry.key);
+            }
+            break;
+        }
+        case JournalField::WeaponDamage: {
+            std::uint64_t subject = ItemCatalog::global().hashKeyOf(entry.item);
+            auto it = weaponDamageLookup.find(entry.item);
+            if (it != weaponDamageLookup.end()) {
+                toggleHash(statehash::Tag::WeaponDamage, subject, it->second);
+            }
+
+            if (entry.existed) {
+                weaponDamageLookup[entry.item] = entry.oldValue;
+                toggleHash(statehash::Tag::WeaponDamage, subject, entry.oldValue);
+            } else {
+                weaponDamageLookup.erase(entry.item);
+            }
+            break;
+        }
+        case JournalField::StatusEffect:
+            storeEffectExpiry(entry.item, entry.oldValue);
+            break;
+        case JournalField::Turn:
+            assignHashed(turn, statehash::Tag::Turn, entry.oldValue);
+            rebuildEffectWheel();
+            break;
+        case JournalField::CriticalRate:
+            assignHashed(critSettings.rate, statehash::Tag::CriticalRate, entry.oldValue);
+            break;
+        case JournalField::CriticalMultiplier:
+            assignHashed(critSettings.modifier, statehash::Tag::CriticalMultiplier,
+                         entry.oldValue);
+            break;
+    }
+}
+
+// state hashing
+void Character::toggleHash(statehash::Tag tag, std::uint64_t subject, std::int64_t value) {
+    stateHash ^= statehash::key(tag, subject, value);
+}
+
+void Character::assignHashed(int& field, statehash::Tag tag, std::uint64_t subject,
+                             int value) {
+    toggleHash(tag, subject, field);
+    field = value;
+    toggleHash(tag, subject, field);
+}
+
+void Character::assignHashed(int& field, statehash::Tag tag, int value) {
+    assignHashed(field, tag, 0, value);
+}
+
+std::uint64_t Character::getStateHash() const { return stateHash; }
+
+std::uint64_t Character::computeStateHash() const {
+    using statehash::Tag;
+    using statehash::key;
+
+    std::uint64_t hash = key(Tag::Name, statehash::ofString(name), 0);
+    hash ^= key(Tag::Health, currentHealth);
+    hash ^= key(Tag::MaxHealth, maxHealth);
+    hash ^= key(Tag::Experience, experience);
+    hash ^= key(Tag::Level, level);
+    hash ^= key(Tag::Turn, turn);
+    hash ^= key(Tag::CriticalRate, critSettings.rate);
+    hash ^= key(Tag::CriticalMultiplier, critSettings.modifier);
+
+    for (const auto& pair : stats) {
+        hash ^= key(Tag::Stat, statehash::ofString(pair.first), pair.second);
+    }
+
+    for (const auto& stack : inventory) {
+        hash ^= key(Tag::Item, ItemCatalog::global().hashKeyOf(stack.item), stack.count);
+    }
+
+    for (const auto& pair : gear) {
+        hash ^= key(Tag::Gear, statehash::ofString(pair.first),
+                    ItemCatalog::global().hashKeyOf(pair.second));
+    }
+
+    for (const auto& pair : weaponDamageLookup) {
+        hash ^= key(Tag::WeaponDamage, ItemCatalog::global().hashKeyOf(pair.first),
+                    pair.second);
+    }
+
+    for (StatusEffectId id : activeEffects) {
+        hash ^= key(Tag::StatusEffect, StatusEffectManager::global().hashKeyOf(id),
+                    effectExpiryOf(id));
+    }
+
+    return hash;
+}
+
+// memory accounting
+CharacterMemoryUsage Character::getMemoryUsage() const {
+    CharacterMemoryUsage usage;
+    usage.object = sizeof(Character);
+    usage.name = memory::stringHeap(name);
+
+    usage.stats = memory::mapNodes(stats) + memory::vectorHeap(statSlots);
+    for (const auto& pair : stats) {
+        usage.stats += memory::stringHeap(pair.first);
+    }
+
+    if (!inventory.usesInlineStorage()) {
+        usage.inventory = inventory.capacity() * sizeof(ItemStack);
+    }
+
+    usage.gear = memory::mapNodes(gear);
+    for (const auto& pair : gear) {
+        usage.gear += memory::stringHeap(pair.first);
+    }
+
+    usage.weaponTable = memory::mapNodes(weaponDamageLookup);
+
+    using AbilityPointer = bool (*)(Character&, Character&);
+    usage.abilities = memory::mapNodes(abilityLookup);
+    for (const auto& pair : abilityLookup) {
+        usage.abilities += memory::stringHeap(pair.first);
+
+        // shared programs are counted by every character holding them
+        const LearnedAbility& learned = pair.second;
+        if (learned.program) {
+            usage.abilities += learned.program->getHeapBytes();
+        } else if (learned.function &&
+                   learned.function.target<AbilityPointer>() == nullptr) {
+            usage.opaqueAbilities++;
+        }
+    }
+
+    usage.statusEffects = memory::vectorHeap(effectExpiry) + effectWheel.getHeapBytes();
+    if (!activeEffects.usesInlineStorage()) {
+        usage.statusEffects += activeEffects.capacity() * sizeof(StatusEffectId);
+    }
+    if (!tickingEffects.usesInlineStorage()) {
+        usage.statusEffects += tickingEffects.capacity() * sizeof(StatusEffectId);
+    }
+
+    return usage;
 }
 
 // serialization
@@ -203,16 +805,16 @@ std::string Character::serialize() const {
 
     ss << inventory.size() << '\n';
 
-    for (const auto& pair : inventory) {
-        ss << pair.first << '\n';
-        ss << pair.second << '\n';
+    for (const auto& stack : sortedInventory()) {
+        ss << stack.first << '\n';
+        ss << stack.second << '\n';
     }
 
     ss << gear.size() << '\n';
 
     for (const auto& pair : gear) {
         ss << pair.first << '\n';
-        ss << pair.second << '\n';
+        ss << ItemCatalog::global().nameOf(pair.second) << '\n';
     }
 
     return ss.str();
@@ -242,7 +844,7 @@ Character Character::deserialize(const std::string& data) {
         ss >> value;
         ss.ignore();
 
-        ch.stats[key] = value;
+        ch.storeStat(key, value);
     }
 
     size_t inventoryMapSize;
@@ -257,7 +859,7 @@ Character Character::deserialize(const std::string& data) {
         ss >> value;
         ss.ignore();
 
-        ch.inventory[key] = value;
+        ch.inventory.push_back({ItemCatalog::global().idFor(key), value});
     }
 
     size_t gearMapSize;
@@ -270,10 +872,75 @@ Character Character::deserialize(const std::string& data) {
 
         std::getline(ss, key);
         std::getline(ss, value);
-        ss.ignore();
 
-        ch.gear[key] = value;
+        ch.gear[key] = ItemCatalog::global().idFor(value);
     }
 
+    ch.stateHash = ch.computeStateHash();
     return ch;
 }
+
+void Character::writeRecord(std::string& out, StringTableWriter& strings) const {
+    using namespace binary;
+
+    putVarUint(out, strings.intern(name));
+    putVarInt(out, level);
+    putVarInt(out, experience);
+    putVarInt(out, maxHealth);
+    putVarInt(out, currentHealth);
+
+    putVarUint(out, stats.size());
+    for (const auto& pair : stats) {
+        putVarUint(out, strings.intern(pair.first));
+        putVarInt(out, pair.second);
+    }
+
+    putVarUint(out, inventory.size());
+    for (const auto& stack : sortedInventory()) {
+        putVarUint(out, strings.intern(stack.first));
+        putVarInt(out, stack.second);
+    }
+
+    putVarUint(out, gear.size());
+    for (const auto& pair : gear) {
+        putVarUint(out, strings.intern(pair.first));
+        putVarUint(out, strings.intern(ItemCatalog::global().nameOf(pair.second)));
+    }
+}
+
+Character Character::readRecord(const std::string& data, size_t& pos,
+                                StringTableReader& strings) {
+    using namespace binary;
+
+    Character ch{};
+    ch.name = strings.at(getVarUint(data, pos));
+    ch.level = static_cast<int>(getVarInt(data, pos));
+    ch.experience = static_cast<int>(getVarInt(data, pos));
+    ch.maxHealth = static_cast<int>(getVarInt(data, pos));
+    ch.currentHealth = static_cast<int>(getVarInt(data, pos));
+
+    // stats and gear were written in key order, so hinted inserts at end()
+    // build each map without searching
+    std::uint64_t statCount = getVarUint(data, pos);
+    for (std::uint64_t i = 0; i < statCount; i++) {
+        const std::string& stat = strings.at(getVarUint(data, pos));
+        int value = static_cast<int>(getVarInt(data, pos));
+        ch.stats.emplace_hint(ch.stats.end(), stat, value);
+        ch.setStatSlot(stat, value);
+    }
+
+    std::uint64_t stackCount = getVarUint(data, pos);
+    for (std::uint64_t i = 0; i < stackCount; i++) {
+        ItemId item = strings.itemAt(getVarUint(data, pos));
+        ch.inventory.push_back({item, static_cast<int>(getVarInt(data, pos))});
+    }
+
+    std::uint64_t gearCount = getVarUint(data, pos);
+    for (std::uint64_t i = 0; i < gearCount; i++) {
+        const std::string& slot = strings.at(getVarUint(data, pos));
+        ch.gear.emplace_hint(ch.gear.end(), slot, strings.itemAt(getVarUint(data, pos)));
+    }
+
+    ch.stateHash = ch.computeStateHash();
+    return ch;
+}
\ No newline at end of file
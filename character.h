@@ -2,8 +2,21 @@
 #include <string>
 #include <map>
 #include <functional>
+#include <memory>
+#include <vector>
+#include "AbilityScript.h"
 #include "CombatSystem.h"
+#include "ItemCatalog.h"
+#include "MemoryUsage.h"
+#include "MutationJournal.h"
+#include "SmallVector.h"
+#include "StatRegistry.h"
+#include "StateHash.h"
+#include "StatusEffect.h"
+#include "TimingWheel.h"
 
+class StringTableReader;
+class StringTableWriter;
 
 class Character{
 private:
@@ -14,13 +27,59 @@ private:
     int level{1};
 
     std::map<std::string, int> stats {};
-    std::map<std::string, int> inventory {};
-    std::map<std::string, std::string> gear {};
-    std::map<std::string, int> weaponDamageLookup {};
-    std::map<std::string, std::function<bool(Character&, Character&)>> abilityLookup {};
-    std::map<std::string, int> statusEffects {}; 
+    // the same values indexed by StatId (0 where unset) for compiled abilities
+    std::vector<int> statSlots {};
+    SmallVector<ItemStack, 4> inventory {};
+    std::map<std::string, ItemId> gear {};
+    std::map<ItemId, int> weaponDamageLookup {};
+    // an ability is either a native function or a compiled script
+    struct LearnedAbility {
+        std::function<bool(Character&, Character&)> function {};
+        std::shared_ptr<const AbilityProgram> program {};
+    };
+    std::map<std::string, LearnedAbility> abilityLookup {};
+
+    // status effects are stored by absolute expiry turn (0 = inactive), indexed
+    // by effect id, and expired through a timing wheel
+    int turn {};
+    std::vector<int> effectExpiry {};
+    SmallVector<StatusEffectId, 4> activeEffects {};
+    SmallVector<StatusEffectId, 4> tickingEffects {};
+    TimingWheel effectWheel {};
 
     CriticalHitSettings critSettings {};
+    JournalLink journalLink {};
+
+    DerivedStats derivedStats {};
+    bool derivedStatsValid {false};
+    std::uint64_t derivedCatalogVersion {};
+
+    // zobrist hash of the gameplay state, kept current by every mutation
+    std::uint64_t stateHash {};
+
+    ItemStack* findStack(ItemId item);
+    const ItemStack* findStack(ItemId item) const;
+    const ItemStack* findStack(const std::string& item) const;
+    // (name, count) pairs sorted by name, the canonical order for the text
+    // and binary formats whatever order the stacks were added in
+    std::vector<std::pair<std::string, int>> sortedInventory() const;
+    int weaponDamageFor(ItemId weapon) const;
+    int statValue(const std::string& stat) const;
+    void storeStat(const std::string& stat, int value);
+    void eraseStat(const std::string& stat);
+    void setStatSlot(const std::string& stat, int value);
+    void invalidateDerivedStats();
+    int effectExpiryOf(StatusEffectId id) const;
+    void storeEffectExpiry(StatusEffectId id, int expiry);
+    void rebuildEffectWheel();
+    static void removeEffectId(SmallVector<StatusEffectId, 4>& effects, StatusEffectId id);
+    void toggleHash(statehash::Tag tag, std::uint64_t subject, std::int64_t value);
+    // stores value into a hashed field, swapping its hash key
+    void assignHashed(int& field, statehash::Tag tag, std::uint64_t subject, int value);
+    void assignHashed(int& field, statehash::Tag tag, int value);
+
+    friend class MutationJournal;
+    void revert(const JournalEntry& entry);
 public: 
     Character();
     Character(std::string name, int health);
@@ -31,50 +90,95 @@ public:
     static Character createRogue(const std::string& name);
 
     void setName(std::string value);
-    std::string getName();
+    std::string getName() const;
 
     // level and exp
-    int getLevel();
+    int getLevel() const;
     void gainExperience(int exp);
-    int getExperience();
+    int getExperience() const;
 
     // health system
     void setHealth(int value);
-    int getHealth();
-    int getMaxHealth();
+    int getHealth() const;
+    int getMaxHealth() const;
     void takeDamage(int value);
     void heal(int value);
-    bool isDead();
+    bool isDead() const;
 
     // stats
     void setStat(std::string stat, int value);
-    int getStat(std::string stat);
+    int getStat(const std::string& stat);
+    // id overloads; reads are a vector index, no name lookup
+    void setStat(StatId stat, int value);
+    int getStat(StatId stat) const;
 
     // items + equipment
     void equip(std::string item, std::string slot);
     std::string getEquipped(std::string slot);
-    void addToInventory(std::string item, int count = 1);
-    bool hasItem(std::string item);
-    int getItemCount(std::string item);
+    // name overloads resolve the item through the global catalog on every
+    // call; hot paths should resolve an ItemId once and use the id overloads
+    void addToInventory(const std::string& item, int count = 1);
+    void addToInventory(ItemId item, int count = 1);
+    bool hasItem(const std::string& item) const;
+    bool hasItem(ItemId item) const;
+    int getItemCount(const std::string& item) const;
+    int getItemCount(ItemId item) const;
     int getInventoryCount();
-    bool useItem(std::string item, int count);
+    bool useItem(const std::string& item, int count);
+    bool useItem(ItemId item, int count);
 
     // combat
     void attack(Character& character);
+    // attack with the critical roll decided by the caller
+    void resolveAttack(Character& character, bool critical);
     void setWeaponDamage(std::string weapon, int damage);
     void setCriticalRate(double critChance);
     void setCriticalMultiplier(double damageMultiplier);
+    double getCriticalRate() const;
+    // attack power and crit numbers, recomputed only when an input changed
+    const DerivedStats& getDerivedStats();
 
     // abilities
     void learnAbility(std::string ability, std::function<bool(Character&, Character&)> abilityFunction);
+    void learnAbility(std::string ability, std::shared_ptr<const AbilityProgram> program);
     bool useAbility(std::string ability, Character& target);
+    bool hasAbility(const std::string& ability) const;
+    std::vector<std::string> getAbilityNames() const;
+    // the compiled script behind an ability, or nullptr for native ones
+    std::shared_ptr<const AbilityProgram> getAbilityProgram(const std::string& ability) const;
 
     // status effects
     void applyStatusEffect(std::string status, int turnCount);
+    void applyStatusEffect(StatusEffectId id, int turnCount);
     bool hasStatusEffect(std::string status);
+    bool hasStatusEffect(StatusEffectId id);
+    int getStatusEffectTurns(std::string status);
+    // active effects by name with their remaining turns
+    std::map<std::string, int> getStatusEffects() const;
+    int getTurn() const;
     void processTurn();
 
+    // undo journal; nullptr detaches
+    void attachJournal(MutationJournal* journal);
+
+    // lockstep desync detection. getStateHash is maintained incrementally;
+    // computeStateHash rebuilds it from scratch and must always agree. the
+    // hash covers name, health, level, experience, stats, inventory, gear,
+    // weapon overrides, crit settings, status effects and the turn counter.
+    std::uint64_t getStateHash() const;
+    std::uint64_t computeStateHash() const;
+
+    // estimated footprint by component, see MemoryUsage.h
+    CharacterMemoryUsage getMemoryUsage() const;
+
     // serialization
     std::string serialize() const;
     static Character deserialize(const std::string& data);
+
+    // compact binary record used by Party::serialize: what serialize carries
+    // plus current and max health, with every name stored as a reference
+    // into the shared string table
+    void writeRecord(std::string& out, StringTableWriter& strings) const;
+    static Character readRecord(const std::string& data, size_t& pos,
+                                StringTableReader& strings);
 };  
\ No newline at end of file
@@ -1,36 +1,63 @@
 #include "CharacterTests.h"
 
 int main() {
-    TestRunner::runTest("CreateCharacterWithNameAndHealth",
+    TestRunner runner;
+
+    runner.addTest("CreateCharacterWithNameAndHealth",
                         testCreateCharacterWithNameAndHealth);
-    TestRunner::runTest("CharacterTakesDamage", testCharacterTakesDamage);
-    TestRunner::runTest("HealthCannotBeBelowZero", testHealthCannotBeBelowZero);
-    TestRunner::runTest("CharacterCanHeal", testCharacterCanHeal);
-    TestRunner::runTest("HealthCannotExceedMaximum",
+    runner.addTest("CharacterTakesDamage", testCharacterTakesDamage);
+    runner.addTest("HealthCannotBeBelowZero", testHealthCannotBeBelowZero);
+    runner.addTest("CharacterCanHeal", testCharacterCanHeal);
+    runner.addTest("HealthCannotExceedMaximum",
                         testHealthCannotExceedMaximum);
-    TestRunner::runTest("CharacterCanAddItemToInventory",
+    runner.addTest("CharacterCanAddItemToInventory",
                         testCharacterCanAddItemToInventory);
-    TestRunner::runTest("CharacterHasStats", testCharacterHasStats);
-    TestRunner::runTest("CharacterCanEquipItems", testCharacterCanEquipItems);
-    TestRunner::runTest("CharacterCanAttackOthers",
+    runner.addTest("CharacterHasStats", testCharacterHasStats);
+    runner.addTest("CharacterCanEquipItems", testCharacterCanEquipItems);
+    runner.addTest("CharacterCanAttackOthers",
                         testCharacterCanAttackOthers);
-    TestRunner::runTest("WeaponDamageModifiers", testWeaponDamageModifiers);
-    TestRunner::runTest("CharacterDeath", testCharacterDeath);
+    runner.addTest("WeaponDamageModifiers", testWeaponDamageModifiers);
+    runner.addTest("CharacterDeath", testCharacterDeath);
 
-    TestRunner::runTest("CharacterExperienceAndLeveling",
+    runner.addTest("CharacterExperienceAndLeveling",
                         testCharacterExperienceAndLeveling);
-    TestRunner::runTest("CharacterSpecialAbilities",
+    runner.addTest("CharacterSpecialAbilities",
                         testCharacterSpecialAbilities);
-    TestRunner::runTest("CharacterClasses", testCharacterClasses);
+    runner.addTest("CharacterClasses", testCharacterClasses);
+
+    runner.addTest("StatusEffects", testStatusEffects);
+    runner.addTest("CombatModifiers", testCombatModifiers);
+    runner.addTest("StackableInventory", testStackableInventory);
+
+    runner.addTest("PartyMechanics", testPartyMechanics);
+    runner.addTest("CharacterSerialization", testCharacterSerialization);
 
-    TestRunner::runTest("StatusEffects", testStatusEffects);
-    TestRunner::runTest("CombatModifiers", testCombatModifiers);
-    TestRunner::runTest("StackableInventory", testStackableInventory);
+    runner.addTest("CompleteBattleScenario", testCompleteBattleScenario);
 
-    TestRunner::runTest("PartyMechanics", testPartyMechanics);
-    TestRunner::runTest("CharacterSerialization", testCharacterSerialization);
+    // checks the global catalog's item count, which parallel tests change
+    runner.addSerialTest("ItemCatalog", testItemCatalog);
+    runner.addTest("TestRunnerTimeBudgets", testTestRunnerTimeBudgets);
+    runner.addTest("RosterSnapshot", testRosterSnapshot);
+    runner.addTest("MutationJournal", testMutationJournal);
+    runner.addTest("CombatPlanner", testCombatPlanner);
+    runner.addTest("StatusEffectTimingWheel", testStatusEffectTimingWheel);
+    runner.addTest("DerivedStatsCache", testDerivedStatsCache);
+    runner.addTest("SimulationServer", testSimulationServer,
+                   std::chrono::milliseconds(5000));
+    runner.addTest("CharacterStore", testCharacterStore,
+                   std::chrono::milliseconds(5000));
+    runner.addTest("StateHashing", testStateHashing);
+    runner.addTest("MemoryAccounting", testMemoryAccounting);
+    runner.addTest("PartySerialization", testPartySerialization);
+    runner.addTest("AbilityScript", testAbilityScript);
+    runner.addTest("PartySnapshots", testPartySnapshots, std::chrono::milliseconds(5000));
 
-    TestRunner::runTest("CompleteBattleScenario", testCompleteBattleScenario);
+    // latency guards for hot paths. budgeted tests run serially, so the budgets
+    // are about 5x the baseline of an unoptimized build (7ms and 18ms)
+    runner.addTest("SerializeLatency", testSerializeLatency,
+                   std::chrono::milliseconds(40));
+    runner.addTest("ProcessTurnLatency", testProcessTurnLatency,
+                   std::chrono::milliseconds(100));
 
-    return 0;
+    return runner.runAll() == 0 ? 0 : 1;
 }
\ No newline at end of file
@@ -0,0 +1,36 @@
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+#include "SimulationServer.h"
+
+namespace {
+volatile std::sig_atomic_t stopRequested = 0;
+
+void requestStop(int) { stopRequested = 1; }
+}  // namespace
+
+// usage: sim_server [socket path] [worker count]
+int main(int argc, char* argv[]) {
+    std::string socketPath = argc > 1 ? argv[1] : "/tmp/tdd_character_sim.sock";
+    unsigned workers = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 0;
+
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+
+    SimulationServer server(socketPath, workers);
+    server.start();
+    std::cout << "simulation server listening on " << socketPath << std::endl;
+
+    while (!stopRequested) {
+        pause();
+    }
+
+    server.stop();
+    std::cout << "completed " << server.getCompletedJobs() << " jobs" << std::endl;
+
+    return 0;
+}